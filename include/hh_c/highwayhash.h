@@ -9,27 +9,13 @@
 extern "C" {
 #endif
 
+struct iovec;
 
-#ifdef HIGHWAYHASH_AVX2
-#include <immintrin.h>
+/* The state layout is the same for every backend, so a state produced by one
+   backend can be continued by another and callers never need to be rebuilt
+   for a particular host. */
 typedef struct {
-  __m256i v0;
-  __m256i v1;
-  __m256i mul0;
-  __m256i mul1;
-} HighwayHashState;
-
-typedef struct {
-  HighwayHashState state;
-  alignas(alignof(__m256i)) uint8_t packet[32];
-  size_t num;
-} HighwayHashCat;
-#else
-#ifndef HIGHWAYHASH_PORTABLE
-#define HIGHWAYHASH_PORTABLE
-#endif
-typedef struct {
-  uint64_t v0[4];
+  alignas(32) uint64_t v0[4];
   uint64_t v1[4];
   uint64_t mul0[4];
   uint64_t mul1[4];
@@ -37,10 +23,15 @@ typedef struct {
 
 typedef struct {
   HighwayHashState state;
-  uint8_t packet[32];
+  alignas(32) uint8_t packet[32];
   size_t num;
 } HighwayHashCat;
-#endif
+
+/* A key expanded once into the state every hash with it starts from. The
+   state fills exactly two cache lines. */
+typedef struct {
+  alignas(64) HighwayHashState state;
+} HighwayHashKey;
 
 /*////////////////////////////////////////////////////////////////////////////*/
 /* Low-level API, use for implementing streams etc...                         */
@@ -65,6 +56,16 @@ void HighwayHashFinalize256(HighwayHashState *state, uint64_t *hash);
 /* Non-cat API: single call on full data                                      */
 /*////////////////////////////////////////////////////////////////////////////*/
 
+/* The inline API (-Dinline_api=true) makes these and the pre-keyed
+   functions below static inline, see highwayhash_inline.h. It only takes
+   over where the inline code is not slower than the library: when compiled
+   for AVX2, or for CPUs the library has no SIMD backend for. */
+#if defined(HIGHWAYHASH_INLINE) &&                                             \
+    (defined(__AVX2__) || !(defined(__x86_64__) || defined(__i386__)))
+#define HIGHWAYHASH_INLINE_API 1
+#endif
+
+#ifndef HIGHWAYHASH_INLINE_API
 uint64_t HighwayHash64(const uint8_t *data, size_t size, const uint64_t *key);
 
 void HighwayHash128(const uint8_t *data, size_t size, const uint64_t *key,
@@ -73,6 +74,76 @@ void HighwayHash128(const uint8_t *data, size_t size, const uint64_t *key,
 void HighwayHash256(const uint8_t *data, size_t size, const uint64_t *key,
                     uint64_t *hash);
 
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Pre-keyed API: skips the key setup when one key is used for many calls     */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Expands key, the result is independent of the selected backend */
+void HighwayHashKeyInit(HighwayHashKey *hkey, const uint64_t *key);
+
+/* Same results as HighwayHash64/128/256 with the key hkey was built from */
+uint64_t HighwayHash64WithKey(const uint8_t *data, size_t size,
+                              const HighwayHashKey *hkey);
+
+void HighwayHash128WithKey(const uint8_t *data, size_t size,
+                           const HighwayHashKey *hkey, uint64_t *hash);
+
+void HighwayHash256WithKey(const uint8_t *data, size_t size,
+                           const HighwayHashKey *hkey, uint64_t *hash);
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Fixed-width API: single packet inputs of a size known at compile time      */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Each function returns exactly what HighwayHash64/128 returns for the same
+   bytes, integers being hashed as their little-endian encoding. The packet
+   layout is fixed, so there is no loop and no remainder handling. */
+uint64_t HighwayHash64_U32(uint32_t value, const uint64_t *key);
+uint64_t HighwayHash64_U64(uint64_t value, const uint64_t *key);
+uint64_t HighwayHash64_16B(const uint8_t *data, const uint64_t *key);
+uint64_t HighwayHash64_32B(const uint8_t *data, const uint64_t *key);
+
+void HighwayHash128_U32(uint32_t value, const uint64_t *key, uint64_t *hash);
+void HighwayHash128_U64(uint64_t value, const uint64_t *key, uint64_t *hash);
+void HighwayHash128_16B(const uint8_t *data, const uint64_t *key,
+                        uint64_t *hash);
+void HighwayHash128_32B(const uint8_t *data, const uint64_t *key,
+                        uint64_t *hash);
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Batch API: many independent messages with the same key                     */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Hashes count messages, hashes[i] equals
+   HighwayHash64(data[i], sizes[i], key). Several messages are processed in
+   lockstep so that their latency overlaps, which pays off for short keys. */
+void HighwayHash64Batch(const uint8_t *const *data, const size_t *sizes,
+                        size_t count, const uint64_t *key, uint64_t *hashes);
+
+/* Same as above, hashes[2 * i] and hashes[2 * i + 1] receive message i */
+void HighwayHash128Batch(const uint8_t *const *data, const size_t *sizes,
+                         size_t count, const uint64_t *key, uint64_t *hashes);
+
+/* Same as HighwayHash64Batch with a key from HighwayHashKeyInit, for callers
+   that hash many small batches under one key */
+void HighwayHash64BatchWithKey(const uint8_t *const *data, const size_t *sizes,
+                               size_t count, const HighwayHashKey *hkey,
+                               uint64_t *hashes);
+
+void HighwayHash128BatchWithKey(const uint8_t *const *data,
+                                const size_t *sizes, size_t count,
+                                const HighwayHashKey *hkey, uint64_t *hashes);
+
+/* Hashes one message under k keys, keys holds k consecutive 4-word keys and
+   hashes[i] equals HighwayHash64(data, size, keys + 4 * i). Keys are taken
+   in groups of 4, or 8 with the AVX-512 backend, and each packet is read
+   once per group: for more keys the message is read again for every group,
+   from cache unless it is large. This suits multi-key sketches and probing
+   with several independent hash functions. */
+void HighwayHash64MultiKey(const uint8_t *data, size_t size,
+                           const uint64_t *keys, size_t k, uint64_t *hashes);
+
 /*////////////////////////////////////////////////////////////////////////////*/
 /* Cat API: allows appending with multiple calls                              */
 /*////////////////////////////////////////////////////////////////////////////*/
@@ -80,14 +151,94 @@ void HighwayHash256(const uint8_t *data, size_t size, const uint64_t *key,
 /* Allocates new state for a new streaming hash computation */
 void HighwayHashCatStart(HighwayHashCat *state, const uint64_t *key);
 
+/* Same as above, with a key from HighwayHashKeyInit */
+void HighwayHashCatStartWithKey(HighwayHashCat *state,
+                                const HighwayHashKey *hkey);
+
 void HighwayHashCatAppend(HighwayHashCat *state, const uint8_t *bytes,
                           size_t num);
 
+/* Appends iovcnt fragments in order, the same as one HighwayHashCatAppend
+   per fragment. Include <sys/uio.h> for struct iovec. */
+void HighwayHashCatAppendV(HighwayHashCat *state, const struct iovec *iov,
+                           int iovcnt);
+
 /* Computes final hash value */
 uint64_t HighwayHashCatFinish64(const HighwayHashCat *state);
 void HighwayHashCatFinish128(const HighwayHashCat *state, uint64_t *hash);
 void HighwayHashCatFinish256(const HighwayHashCat *state, uint64_t *hash);
 
+/* Size of the byte form written by HighwayHashCatSerialize */
+#define HIGHWAYHASH_CAT_SERIALIZED_SIZE 176
+
+/* Writes state as HIGHWAYHASH_CAT_SERIALIZED_SIZE bytes in a versioned,
+   little-endian format that does not depend on the backend, the byte order
+   or the word size. A stream hashed up to some point can be saved and
+   resumed later, in another process or on another machine, without
+   rehashing what came before. The key can be derived from the bytes, so
+   treat them as secret where the key is. */
+void HighwayHashCatSerialize(const HighwayHashCat *state, uint8_t *bytes);
+
+/* Restores a state written by HighwayHashCatSerialize. Returns 0 on
+   success, -1 if size is wrong or the bytes are not a valid state of a
+   known version, which leaves state untouched. */
+int HighwayHashCatDeserialize(HighwayHashCat *state, const uint8_t *bytes,
+                              size_t size);
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Prefix API: hashes of many prefixes in one sequential pass                 */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* offsets must be ascending, repeats are allowed. hashes[i] equals
+   HighwayHash64(data, offsets[i], key), every byte is read once. */
+void HighwayHash64Prefixes(const uint8_t *data, const size_t *offsets,
+                           size_t count, const uint64_t *key,
+                           uint64_t *hashes);
+
+/* Same as above, hashes[2 * i] and hashes[2 * i + 1] receive prefix i */
+void HighwayHash128Prefixes(const uint8_t *data, const size_t *offsets,
+                            size_t count, const uint64_t *key,
+                            uint64_t *hashes);
+
+/* Streaming form: appends num bytes like HighwayHashCatAppend. hashes[i]
+   receives HighwayHashCatFinish64 of the state after the first offsets[i]
+   of these bytes, offsets must be ascending and at most num. */
+void HighwayHashCatAppendPrefixes64(HighwayHashCat *state,
+                                    const uint8_t *bytes, size_t num,
+                                    const size_t *offsets, size_t count,
+                                    uint64_t *hashes);
+
+void HighwayHashCatAppendPrefixes128(HighwayHashCat *state,
+                                     const uint8_t *bytes, size_t num,
+                                     const size_t *offsets, size_t count,
+                                     uint64_t *hashes);
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Backend selection                                                          */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+typedef enum {
+  HIGHWAYHASH_BACKEND_PORTABLE = 0,
+  HIGHWAYHASH_BACKEND_AVX2 = 1,
+  HIGHWAYHASH_BACKEND_AVX512 = 2,
+  HIGHWAYHASH_BACKEND_SSE41 = 3,
+  HIGHWAYHASH_BACKEND_COUNT
+} HighwayHashBackend;
+
+/* The fastest backend that is compiled in and supported by the CPU is picked
+   when the library is loaded. All backends produce identical hashes. */
+HighwayHashBackend HighwayHashGetBackend(void);
+
+/* Returns nonzero if the backend is compiled in and supported by the CPU */
+int HighwayHashBackendAvailable(HighwayHashBackend backend);
+
+/* Forces a backend, returns 0 on success and -1 if it is not available.
+   Must not race with hashing on other threads. */
+int HighwayHashSetBackend(HighwayHashBackend backend);
+
+/* Returns a short lowercase name such as "avx2" */
+const char *HighwayHashBackendName(HighwayHashBackend backend);
+
 /*
 Usage examples:
 
@@ -121,4 +272,8 @@ void Example64Cat() {
 } /* extern "C" */
 #endif
 
+#ifdef HIGHWAYHASH_INLINE_API
+#include "hh_c/highwayhash_inline.h"
+#endif
+
 #endif // C_HIGHWAYHASH_H_
@@ -0,0 +1,298 @@
+#ifndef C_HIGHWAYHASH_HPP_
+#define C_HIGHWAYHASH_HPP_
+
+#include "hh_c/highwayhash.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__cpp_lib_span)
+#include <span>
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* C++ interface, C++17 or later                                              */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+hh_c::HighwayHash<64>("text", key) returns what HighwayHash64 returns for the
+same bytes. In a constant expression it runs the portable algorithm, written
+out below as constexpr code, so hashes of literals can be case labels:
+
+  constexpr hh_c::Key kKey(1, 2, 3, 4);
+  switch (hh_c::HighwayHash(command, kKey)) {
+  case hh_c::HighwayHash("start", kKey):
+    ...
+  }
+
+Evaluated at run time the same call goes to the selected SIMD backend.
+Hasher is a transparent hash function object for unordered containers.
+*/
+
+namespace hh_c {
+
+/* The four key words, which the C API takes as a bare uint64_t[4] */
+struct Key {
+  uint64_t words[4];
+
+  constexpr Key(uint64_t k0, uint64_t k1, uint64_t k2, uint64_t k3)
+      : words{k0, k1, k2, k3} {}
+};
+
+namespace detail {
+
+template <size_t Bits> struct HashType;
+template <> struct HashType<64> { using type = uint64_t; };
+template <> struct HashType<128> { using type = std::array<uint64_t, 2>; };
+template <> struct HashType<256> { using type = std::array<uint64_t, 4>; };
+
+}  // namespace detail
+
+/* uint64_t, or two or four little-endian words as in the C API */
+template <size_t Bits> using Hash = typename detail::HashType<Bits>::type;
+
+namespace detail {
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Constexpr portable implementation                                          */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+struct State {
+  uint64_t v0[4] = {};
+  uint64_t v1[4] = {};
+  uint64_t mul0[4] = {};
+  uint64_t mul1[4] = {};
+};
+
+constexpr State Reset(const Key &key) {
+  constexpr uint64_t kInitMul0[4] = {0xdbe6d5d5fe4cce2f, 0xa4093822299f31d0,
+                                     0x13198a2e03707344, 0x243f6a8885a308d3};
+  constexpr uint64_t kInitMul1[4] = {0x3bd39e10cb0ef593, 0xc0acf169b5f18a8c,
+                                     0xbe5466cf34e90c6c, 0x452821e638d01377};
+  State state;
+  for (int i = 0; i < 4; i++) {
+    const uint64_t k = key.words[i];
+    state.mul0[i] = kInitMul0[i];
+    state.mul1[i] = kInitMul1[i];
+    state.v0[i] = kInitMul0[i] ^ k;
+    state.v1[i] = kInitMul1[i] ^ ((k >> 32) | (k << 32));
+  }
+  return state;
+}
+
+constexpr void ZipperMergeAndAdd(const uint64_t (&v)[4], uint64_t (&add)[4]) {
+  for (int i = 0; i < 4; i += 2) {
+    const uint64_t v0 = v[i];
+    const uint64_t v1 = v[i + 1];
+    add[i] += (((v0 & 0xff000000) | (v1 & 0xff00000000)) >> 24) |
+              (((v0 & 0xff0000000000) | (v1 & 0xff000000000000)) >> 16) |
+              (v0 & 0xff0000) | ((v0 & 0xff00) << 32) |
+              ((v1 & 0xff00000000000000) >> 8) | (v0 << 56);
+    add[i + 1] += (((v1 & 0xff000000) | (v0 & 0xff00000000)) >> 24) |
+                  (v1 & 0xff0000) | ((v1 & 0xff0000000000) >> 16) |
+                  ((v1 & 0xff00) << 24) | ((v0 & 0xff000000000000) >> 8) |
+                  ((v1 & 0xff) << 48) | (v0 & 0xff00000000000000);
+  }
+}
+
+constexpr void Update(State &state, const uint64_t (&lanes)[4]) {
+  for (int i = 0; i < 4; i++) {
+    state.v1[i] += state.mul0[i] + lanes[i];
+    state.mul0[i] ^= (state.v1[i] & 0xffffffff) * (state.v0[i] >> 32);
+    state.v0[i] += state.mul1[i];
+    state.mul1[i] ^= (state.v0[i] & 0xffffffff) * (state.v1[i] >> 32);
+  }
+  ZipperMergeAndAdd(state.v1, state.v0);
+  ZipperMergeAndAdd(state.v0, state.v1);
+}
+
+/* Little-endian value of num bytes at pos, Bytes is anything indexable */
+template <typename Bytes>
+constexpr uint64_t Load(const Bytes &bytes, size_t pos, int num) {
+  uint64_t value = 0;
+  for (int i = 0; i < num; i++) {
+    value |= uint64_t{static_cast<uint8_t>(bytes[pos + i])} << (8 * i);
+  }
+  return value;
+}
+
+template <typename Bytes>
+constexpr void Process(State &state, const Bytes &bytes, size_t size) {
+  size_t pos = 0;
+  for (; pos + 32 <= size; pos += 32) {
+    const uint64_t lanes[4] = {Load(bytes, pos, 8), Load(bytes, pos + 8, 8),
+                               Load(bytes, pos + 16, 8),
+                               Load(bytes, pos + 24, 8)};
+    Update(state, lanes);
+  }
+  const uint32_t size_mod32 = static_cast<uint32_t>(size & 31);
+  if (size_mod32 == 0) {
+    return;
+  }
+  for (int i = 0; i < 4; i++) {
+    const uint32_t lo = static_cast<uint32_t>(state.v1[i]);
+    const uint32_t hi = static_cast<uint32_t>(state.v1[i] >> 32);
+    state.v0[i] += (uint64_t{size_mod32} << 32) + size_mod32;
+    state.v1[i] =
+        uint64_t{(lo << size_mod32) | (lo >> (32 - size_mod32))} |
+        (uint64_t{(hi << size_mod32) | (hi >> (32 - size_mod32))} << 32);
+  }
+
+  // The remainder packet, laid out as in the portable backend.
+  uint64_t lanes[4] = {0, 0, 0, 0};
+  const uint32_t size_mod4 = size_mod32 & 3;
+  const uint32_t whole = size_mod32 & ~3u;
+  for (uint32_t i = 0; i < whole; i += 4) {
+    lanes[i / 8] |= Load(bytes, pos + i, 4) << (8 * (i & 4));
+  }
+  if (size_mod32 & 16) {
+    lanes[3] |= Load(bytes, pos + size_mod32 - 4, 4) << 32;
+  } else if (size_mod4 != 0) {
+    const size_t remainder = pos + whole;
+    lanes[2] = Load(bytes, remainder, 1) |
+               (Load(bytes, remainder + (size_mod4 >> 1), 1) << 8) |
+               (Load(bytes, remainder + size_mod4 - 1, 1) << 16);
+  }
+  Update(state, lanes);
+}
+
+constexpr void PermuteAndUpdate(State &state, int rounds) {
+  for (int r = 0; r < rounds; r++) {
+    uint64_t permuted[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+      permuted[i] = (state.v0[i ^ 2] >> 32) | (state.v0[i ^ 2] << 32);
+    }
+    Update(state, permuted);
+  }
+}
+
+template <size_t Bits, typename Bytes>
+constexpr Hash<Bits> Compute(const Bytes &bytes, size_t size,
+                             const Key &key) {
+  State state = Reset(key);
+  Process(state, bytes, size);
+  if constexpr (Bits == 64) {
+    PermuteAndUpdate(state, 4);
+    return state.v0[0] + state.v1[0] + state.mul0[0] + state.mul1[0];
+  } else if constexpr (Bits == 128) {
+    PermuteAndUpdate(state, 6);
+    return Hash<128>{
+        state.v0[0] + state.mul0[0] + state.v1[2] + state.mul1[2],
+        state.v0[1] + state.mul0[1] + state.v1[3] + state.mul1[3]};
+  } else {
+    PermuteAndUpdate(state, 10);
+    Hash<256> hash = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i += 2) {
+      const uint64_t a0 = state.v0[i] + state.mul0[i];
+      const uint64_t a1 = state.v0[i + 1] + state.mul0[i + 1];
+      const uint64_t a2 = state.v1[i] + state.mul1[i];
+      const uint64_t a3 =
+          (state.v1[i + 1] + state.mul1[i + 1]) & 0x3FFFFFFFFFFFFFFF;
+      hash[i + 1] = a1 ^ ((a3 << 1) | (a2 >> 63)) ^ ((a3 << 2) | (a2 >> 62));
+      hash[i] = a0 ^ (a2 << 1) ^ (a2 << 2);
+    }
+    return hash;
+  }
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Run-time calls into the library                                            */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+template <size_t Bits>
+inline Hash<Bits> Call(const uint8_t *data, size_t size, const Key &key) {
+  if constexpr (Bits == 64) {
+    return HighwayHash64(data, size, key.words);
+  } else if constexpr (Bits == 128) {
+    Hash<128> hash;
+    HighwayHash128(data, size, key.words, hash.data());
+    return hash;
+  } else {
+    Hash<256> hash;
+    HighwayHash256(data, size, key.words, hash.data());
+    return hash;
+  }
+}
+
+}  // namespace detail
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Hash functions                                                             */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+template <size_t Bits = 64>
+constexpr Hash<Bits> HighwayHash(std::string_view data, const Key &key) {
+  static_assert(Bits == 64 || Bits == 128 || Bits == 256,
+                "HighwayHash has 64, 128 and 256-bit outputs");
+  if (__builtin_is_constant_evaluated()) {
+    return detail::Compute<Bits>(data, data.size(), key);
+  }
+  return detail::Call<Bits>(reinterpret_cast<const uint8_t *>(data.data()),
+                            data.size(), key);
+}
+
+#if defined(__cpp_lib_span)
+template <size_t Bits = 64>
+constexpr Hash<Bits> HighwayHash(std::span<const std::byte> data,
+                                 const Key &key) {
+  static_assert(Bits == 64 || Bits == 128 || Bits == 256,
+                "HighwayHash has 64, 128 and 256-bit outputs");
+  if (std::is_constant_evaluated()) {
+    return detail::Compute<Bits>(data, data.size(), key);
+  }
+  return detail::Call<Bits>(reinterpret_cast<const uint8_t *>(data.data()),
+                            data.size(), key);
+}
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Hash function object for unordered containers                              */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Hashes anything convertible to std::string_view (and byte spans in C++20)
+   with HighwayHash64WithKey. Being transparent, it lets C++20 unordered
+   containers with std::equal_to<> look up std::string keys by string_view
+   without building a string. A default-constructed Hasher uses a key drawn
+   from std::random_device once per process. */
+class Hasher {
+ public:
+  using is_transparent = void;
+
+  Hasher() : Hasher(DefaultKey()) {}
+  explicit Hasher(const Key &key) { HighwayHashKeyInit(&hkey_, key.words); }
+
+  size_t operator()(std::string_view data) const {
+    return static_cast<size_t>(HighwayHash64WithKey(
+        reinterpret_cast<const uint8_t *>(data.data()), data.size(), &hkey_));
+  }
+
+#if defined(__cpp_lib_span)
+  size_t operator()(std::span<const std::byte> data) const {
+    return static_cast<size_t>(HighwayHash64WithKey(
+        reinterpret_cast<const uint8_t *>(data.data()), data.size(), &hkey_));
+  }
+#endif
+
+ private:
+  static const Key &DefaultKey() {
+    static const Key key = [] {
+      std::random_device random;
+      uint64_t words[4];
+      for (uint64_t &word : words) {
+        word = (uint64_t{random()} << 32) ^ random();
+      }
+      return Key(words[0], words[1], words[2], words[3]);
+    }();
+    return key;
+  }
+
+  HighwayHashKey hkey_;
+};
+
+}  // namespace hh_c
+
+#endif // C_HIGHWAYHASH_HPP_
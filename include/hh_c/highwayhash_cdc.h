@@ -0,0 +1,77 @@
+#ifndef C_HIGHWAYHASH_CDC_H_
+#define C_HIGHWAYHASH_CDC_H_
+
+#include "hh_c/highwayhash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Content-defined chunking with a HighwayHash128 fingerprint per chunk       */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+Boundaries follow FastCDC: a gear hash h = (h << 1) + gear[byte] runs over
+each chunk from its minimum size on, and a chunk ends after the first byte
+where the top bits of h are zero. Up to the average size more bits must be
+zero than after it, which pulls chunk sizes towards the average. A chunk
+never exceeds the maximum size.
+
+The gear table is derived from the key, so boundaries of unknown data
+reveal nothing to someone without the key. The fingerprint of a chunk is
+HighwayHash128 of its bytes under the key, computed in the same pass: the
+bytes are scanned a block at a time and hashed while the block is still in
+L1, and the bytes below the minimum size are hashed without being scanned.
+*/
+
+typedef struct {
+  uint64_t offset; /* from the start of the stream */
+  uint64_t length;
+  uint64_t hash[2];
+} HighwayHashChunk;
+
+typedef struct {
+  size_t min_size;
+  size_t avg_size; /* power of two, at least 64 */
+  size_t max_size;
+} HighwayHashCdcOptions;
+
+typedef void (*HighwayHashChunkCallback)(const HighwayHashChunk *chunk,
+                                         void *opaque);
+
+typedef struct {
+  uint64_t gear[256];
+  HighwayHashKey hkey;
+  HighwayHashCat cat;
+  uint64_t mask_small; /* before avg_size, more bits */
+  uint64_t mask_large; /* after avg_size, fewer bits */
+  uint64_t hash;       /* gear hash of the current chunk */
+  uint64_t offset;     /* of the current chunk */
+  size_t size;         /* of the current chunk so far */
+  HighwayHashCdcOptions options;
+} HighwayHashCdc;
+
+/* Starts a stream, options may be NULL for 2 KiB / 8 KiB / 64 KiB. Returns
+   0 on success and -1 if the sizes are not min <= avg <= max with a valid
+   avg_size. */
+int HighwayHashCdcInit(HighwayHashCdc *cdc, const uint64_t *key,
+                       const HighwayHashCdcOptions *options);
+
+/* Consumes size bytes, calling callback for every chunk that ends in them */
+void HighwayHashCdcUpdate(HighwayHashCdc *cdc, const uint8_t *data,
+                          size_t size, HighwayHashChunkCallback callback,
+                          void *opaque);
+
+/* Emits the final chunk, unless the stream ended on a boundary */
+void HighwayHashCdcFinish(HighwayHashCdc *cdc,
+                          HighwayHashChunkCallback callback, void *opaque);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+} /* extern "C" */
+#endif
+
+#endif // C_HIGHWAYHASH_CDC_H_
@@ -0,0 +1,63 @@
+#ifndef C_HIGHWAYHASH_COLUMN_H_
+#define C_HIGHWAYHASH_COLUMN_H_
+
+#include "hh_c/highwayhash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Column kernels: one hash per row of a columnar batch                       */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+The buffers follow the Arrow columnar format. Row i of a binary or string
+column is data[offsets[i]] .. data[offsets[i + 1] - 1], so offsets holds
+count + 1 entries. A fixed-width column has its row i at data + i * stride.
+
+validity may be NULL when every row is valid. Otherwise bit i % 8 of byte
+i / 8 is set for a valid row, as in Arrow; a sliced Arrow array must pass a
+bitmap that starts at its first row. Null rows get
+HIGHWAYHASH_COLUMN_NULL_HASH and are not read.
+
+Valid rows get exactly HighwayHash64WithKey of their bytes. The kernels hash
+several rows in lockstep from the state in hkey, so the latency of one row
+overlaps with the others.
+*/
+
+#define HIGHWAYHASH_COLUMN_NULL_HASH ((uint64_t)0)
+
+/* Binary or string column with 32-bit offsets */
+void HighwayHashColumnBinary(const int32_t *offsets, const uint8_t *data,
+                             const uint8_t *validity, size_t count,
+                             const HighwayHashKey *hkey, uint64_t *hashes);
+
+/* Large binary or string column with 64-bit offsets */
+void HighwayHashColumnLargeBinary(const int64_t *offsets, const uint8_t *data,
+                                  const uint8_t *validity, size_t count,
+                                  const HighwayHashKey *hkey,
+                                  uint64_t *hashes);
+
+/* Fixed-width column: width bytes per row, rows stride bytes apart. Numbers
+   are hashed as their bytes in memory, so the hashes of multi-byte values
+   depend on the byte order. */
+void HighwayHashColumnFixed(const uint8_t *data, size_t width, size_t stride,
+                            const uint8_t *validity, size_t count,
+                            const HighwayHashKey *hkey, uint64_t *hashes);
+
+/* Folds a column's hashes into the row hashes of the columns before it:
+   start with the hashes of the first column and combine the others in
+   order. The result depends on the column order. The fold is not keyed
+   itself and relies on the column hashes being keyed. */
+void HighwayHashColumnCombine(uint64_t *row_hashes,
+                              const uint64_t *column_hashes, size_t count);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+} /* extern "C" */
+#endif
+
+#endif // C_HIGHWAYHASH_COLUMN_H_
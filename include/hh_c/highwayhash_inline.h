@@ -0,0 +1,361 @@
+#ifndef C_HIGHWAYHASH_INLINE_H_
+#define C_HIGHWAYHASH_INLINE_H_
+
+#include "hh_c/highwayhash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Header-only HighwayHash, specialized at every call site                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+Definitions that the compiler sees in full where they are called, so a
+constant size removes the packet loop and the remainder branches, and a
+constant key or pre-keyed state folds into the first update. They give the
+same hashes as the library. Compiled for AVX2 they use the AVX2 backend's
+vector code, otherwise plain scalar code, and they never dispatch at run
+time: on x86 without -mavx2 the library is much faster.
+
+The HighwayHashInline* functions are always available. Building with
+-Dinline_api=true also defines HIGHWAYHASH_INLINE for users of the hh_c
+dependency, which turns HighwayHash64/128/256, their WithKey versions and
+HighwayHashKeyInit into these definitions where highwayhash.h considers
+that a gain.
+*/
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static inline uint64_t HighwayHashInlineLoad64(const uint8_t *src) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t value;
+  memcpy(&value, src, sizeof(value));
+  return value;
+#else
+  return (uint64_t)src[0] | ((uint64_t)src[1] << 8) | ((uint64_t)src[2] << 16) |
+         ((uint64_t)src[3] << 24) | ((uint64_t)src[4] << 32) |
+         ((uint64_t)src[5] << 40) | ((uint64_t)src[6] << 48) |
+         ((uint64_t)src[7] << 56);
+#endif
+}
+
+static inline uint32_t HighwayHashInlineLoad32(const uint8_t *src) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint32_t value;
+  memcpy(&value, src, sizeof(value));
+  return value;
+#else
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+         ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+#endif
+}
+
+static inline void HighwayHashInlineReset(HighwayHashState *state,
+                                          const uint64_t *key) {
+  static const uint64_t kInitMul0[4] = {
+      0xdbe6d5d5fe4cce2f, 0xa4093822299f31d0, 0x13198a2e03707344,
+      0x243f6a8885a308d3};
+  static const uint64_t kInitMul1[4] = {
+      0x3bd39e10cb0ef593, 0xc0acf169b5f18a8c, 0xbe5466cf34e90c6c,
+      0x452821e638d01377};
+  for (int i = 0; i < 4; i++) {
+    state->mul0[i] = kInitMul0[i];
+    state->mul1[i] = kInitMul1[i];
+    state->v0[i] = kInitMul0[i] ^ key[i];
+    state->v1[i] = kInitMul1[i] ^ ((key[i] >> 32) | (key[i] << 32));
+  }
+}
+
+/* Builds the remainder packet of size_mod32 = 1..31 bytes, laid out as in
+   the portable backend. */
+static inline void HighwayHashInlineRemainderLanes(const uint8_t *bytes,
+                                                   size_t size_mod32,
+                                                   uint64_t *lanes) {
+  const size_t size_mod4 = size_mod32 & 3;
+  const size_t whole = size_mod32 & ~(size_t)3;
+  size_t i = 0;
+  lanes[0] = lanes[1] = lanes[2] = lanes[3] = 0;
+  for (; 8 * i + 8 <= whole; i++) {
+    lanes[i] = HighwayHashInlineLoad64(bytes + 8 * i);
+  }
+  if (whole & 4) {
+    lanes[i] = HighwayHashInlineLoad32(bytes + 8 * i);
+  }
+  if (size_mod32 & 16) {
+    lanes[3] |= (uint64_t)HighwayHashInlineLoad32(bytes + size_mod32 - 4)
+                << 32;
+  } else if (size_mod4) {
+    const uint8_t *remainder = bytes + whole;
+    lanes[2] = (uint64_t)remainder[0] |
+               ((uint64_t)remainder[size_mod4 >> 1] << 8) |
+               ((uint64_t)remainder[size_mod4 - 1] << 16);
+  }
+}
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+/* Compiled for AVX2 the state stays in four vectors, as in the AVX2
+   backend. */
+typedef struct {
+  __m256i v0;
+  __m256i v1;
+  __m256i mul0;
+  __m256i mul1;
+} HighwayHashInlineVectors;
+
+static inline void
+HighwayHashInlineUpdate(HighwayHashInlineVectors *state, __m256i lanes) {
+  const __m256i zipper = _mm256_set_epi64x(
+      0x070806090D0A040B, 0x000F010E05020C03, 0x070806090D0A040B,
+      0x000F010E05020C03);
+  state->v1 =
+      _mm256_add_epi64(state->v1, _mm256_add_epi64(state->mul0, lanes));
+  state->mul0 = _mm256_xor_si256(
+      state->mul0,
+      _mm256_mul_epu32(state->v1, _mm256_srli_epi64(state->v0, 32)));
+  state->v0 = _mm256_add_epi64(state->v0, state->mul1);
+  state->mul1 = _mm256_xor_si256(
+      state->mul1,
+      _mm256_mul_epu32(state->v0, _mm256_srli_epi64(state->v1, 32)));
+  state->v0 =
+      _mm256_add_epi64(state->v0, _mm256_shuffle_epi8(state->v1, zipper));
+  state->v1 =
+      _mm256_add_epi64(state->v1, _mm256_shuffle_epi8(state->v0, zipper));
+}
+
+/* Hashes size bytes and runs the given number of finalization rounds */
+static inline void HighwayHashInlineRun(HighwayHashState *state,
+                                        const uint8_t *data, size_t size,
+                                        int rounds) {
+  HighwayHashInlineVectors v;
+  v.v0 = _mm256_loadu_si256((const __m256i_u *)state->v0);
+  v.v1 = _mm256_loadu_si256((const __m256i_u *)state->v1);
+  v.mul0 = _mm256_loadu_si256((const __m256i_u *)state->mul0);
+  v.mul1 = _mm256_loadu_si256((const __m256i_u *)state->mul1);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    HighwayHashInlineUpdate(
+        &v, _mm256_loadu_si256((const __m256i_u *)(data + i)));
+  }
+  if ((size & 31) != 0) {
+    const int size_mod32 = (int)(size & 31);
+    uint64_t lanes[4];
+    HighwayHashInlineRemainderLanes(data + i, size & 31, lanes);
+    v.v0 = _mm256_add_epi64(v.v0, _mm256_set1_epi32(size_mod32));
+    v.v1 = _mm256_or_si256(_mm256_slli_epi32(v.v1, size_mod32),
+                           _mm256_srli_epi32(v.v1, 32 - size_mod32));
+    HighwayHashInlineUpdate(&v, _mm256_setr_epi64x((long long)lanes[0],
+                                                   (long long)lanes[1],
+                                                   (long long)lanes[2],
+                                                   (long long)lanes[3]));
+  }
+  for (int r = 0; r < rounds; r++) {
+    HighwayHashInlineUpdate(
+        &v, _mm256_permutevar8x32_epi32(
+                v.v0, _mm256_setr_epi32(5, 4, 7, 6, 1, 0, 3, 2)));
+  }
+  _mm256_storeu_si256((__m256i_u *)state->v0, v.v0);
+  _mm256_storeu_si256((__m256i_u *)state->v1, v.v1);
+  _mm256_storeu_si256((__m256i_u *)state->mul0, v.mul0);
+  _mm256_storeu_si256((__m256i_u *)state->mul1, v.mul1);
+}
+#else
+static inline void HighwayHashInlineZipperMergeAndAdd(const uint64_t *v,
+                                                      uint64_t *add) {
+  for (int i = 0; i < 4; i += 2) {
+    const uint64_t v0 = v[i];
+    const uint64_t v1 = v[i + 1];
+    add[i] += (((v0 & 0xff000000) | (v1 & 0xff00000000)) >> 24) |
+              (((v0 & 0xff0000000000) | (v1 & 0xff000000000000)) >> 16) |
+              (v0 & 0xff0000) | ((v0 & 0xff00) << 32) |
+              ((v1 & 0xff00000000000000) >> 8) | (v0 << 56);
+    add[i + 1] += (((v1 & 0xff000000) | (v0 & 0xff00000000)) >> 24) |
+                  (v1 & 0xff0000) | ((v1 & 0xff0000000000) >> 16) |
+                  ((v1 & 0xff00) << 24) | ((v0 & 0xff000000000000) >> 8) |
+                  ((v1 & 0xff) << 48) | (v0 & 0xff00000000000000);
+  }
+}
+
+static inline void HighwayHashInlineUpdate(HighwayHashState *state,
+                                           const uint64_t *lanes) {
+  for (int i = 0; i < 4; ++i) {
+    state->v1[i] += state->mul0[i] + lanes[i];
+    state->mul0[i] ^= (state->v1[i] & 0xffffffff) * (state->v0[i] >> 32);
+    state->v0[i] += state->mul1[i];
+    state->mul1[i] ^= (state->v0[i] & 0xffffffff) * (state->v1[i] >> 32);
+  }
+  HighwayHashInlineZipperMergeAndAdd(state->v1, state->v0);
+  HighwayHashInlineZipperMergeAndAdd(state->v0, state->v1);
+}
+
+/* Hashes size bytes and runs the given number of finalization rounds */
+static inline void HighwayHashInlineRun(HighwayHashState *state,
+                                        const uint8_t *data, size_t size,
+                                        int rounds) {
+  uint64_t lanes[4];
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (int j = 0; j < 4; j++) {
+      lanes[j] = HighwayHashInlineLoad64(data + i + 8 * j);
+    }
+    HighwayHashInlineUpdate(state, lanes);
+  }
+  if ((size & 31) != 0) {
+    const uint32_t size_mod32 = (uint32_t)(size & 31);
+    // Each 32-bit half of v1 is rotated by the size.
+    for (int j = 0; j < 4; j++) {
+      const uint32_t lo = (uint32_t)state->v1[j];
+      const uint32_t hi = (uint32_t)(state->v1[j] >> 32);
+      state->v0[j] += ((uint64_t)size_mod32 << 32) + size_mod32;
+      state->v1[j] =
+          (uint64_t)((lo << size_mod32) | (lo >> (32 - size_mod32))) |
+          ((uint64_t)((hi << size_mod32) | (hi >> (32 - size_mod32))) << 32);
+    }
+    HighwayHashInlineRemainderLanes(data + i, size_mod32, lanes);
+    HighwayHashInlineUpdate(state, lanes);
+  }
+  for (int r = 0; r < rounds; r++) {
+    for (int j = 0; j < 4; j++) {
+      lanes[j] = (state->v0[j ^ 2] >> 32) | (state->v0[j ^ 2] << 32);
+    }
+    HighwayHashInlineUpdate(state, lanes);
+  }
+}
+#endif
+
+static inline uint64_t
+HighwayHashInlineFinish64(const HighwayHashState *state) {
+  return state->v0[0] + state->v1[0] + state->mul0[0] + state->mul1[0];
+}
+
+static inline void HighwayHashInlineFinish128(const HighwayHashState *state,
+                                              uint64_t *hash) {
+  hash[0] = state->v0[0] + state->mul0[0] + state->v1[2] + state->mul1[2];
+  hash[1] = state->v0[1] + state->mul0[1] + state->v1[3] + state->mul1[3];
+}
+
+static inline void HighwayHashInlineFinish256(const HighwayHashState *state,
+                                              uint64_t *hash) {
+  for (int i = 0; i < 4; i += 2) {
+    const uint64_t a0 = state->v0[i] + state->mul0[i];
+    const uint64_t a1 = state->v0[i + 1] + state->mul0[i + 1];
+    const uint64_t a2 = state->v1[i] + state->mul1[i];
+    const uint64_t a3 = (state->v1[i + 1] + state->mul1[i + 1]) &
+                        0x3FFFFFFFFFFFFFFF;
+    hash[i + 1] = a1 ^ ((a3 << 1) | (a2 >> 63)) ^ ((a3 << 2) | (a2 >> 62));
+    hash[i] = a0 ^ (a2 << 1) ^ (a2 << 2);
+  }
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Inline API, same results as the library functions of the same name        */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static inline uint64_t HighwayHashInline64(const uint8_t *data, size_t size,
+                                           const uint64_t *key) {
+  HighwayHashState state;
+  HighwayHashInlineReset(&state, key);
+  HighwayHashInlineRun(&state, data, size, 4);
+  return HighwayHashInlineFinish64(&state);
+}
+
+static inline void HighwayHashInline128(const uint8_t *data, size_t size,
+                                        const uint64_t *key, uint64_t *hash) {
+  HighwayHashState state;
+  HighwayHashInlineReset(&state, key);
+  HighwayHashInlineRun(&state, data, size, 6);
+  HighwayHashInlineFinish128(&state, hash);
+}
+
+static inline void HighwayHashInline256(const uint8_t *data, size_t size,
+                                        const uint64_t *key, uint64_t *hash) {
+  HighwayHashState state;
+  HighwayHashInlineReset(&state, key);
+  HighwayHashInlineRun(&state, data, size, 10);
+  HighwayHashInlineFinish256(&state, hash);
+}
+
+static inline void HighwayHashInlineKeyInit(HighwayHashKey *hkey,
+                                            const uint64_t *key) {
+  HighwayHashInlineReset(&hkey->state, key);
+}
+
+static inline uint64_t HighwayHashInline64WithKey(const uint8_t *data,
+                                                  size_t size,
+                                                  const HighwayHashKey *hkey) {
+  HighwayHashState state = hkey->state;
+  HighwayHashInlineRun(&state, data, size, 4);
+  return HighwayHashInlineFinish64(&state);
+}
+
+static inline void HighwayHashInline128WithKey(const uint8_t *data,
+                                               size_t size,
+                                               const HighwayHashKey *hkey,
+                                               uint64_t *hash) {
+  HighwayHashState state = hkey->state;
+  HighwayHashInlineRun(&state, data, size, 6);
+  HighwayHashInlineFinish128(&state, hash);
+}
+
+static inline void HighwayHashInline256WithKey(const uint8_t *data,
+                                               size_t size,
+                                               const HighwayHashKey *hkey,
+                                               uint64_t *hash) {
+  HighwayHashState state = hkey->state;
+  HighwayHashInlineRun(&state, data, size, 10);
+  HighwayHashInlineFinish256(&state, hash);
+}
+
+#ifdef HIGHWAYHASH_INLINE_API
+static inline uint64_t HighwayHash64(const uint8_t *data, size_t size,
+                                     const uint64_t *key) {
+  return HighwayHashInline64(data, size, key);
+}
+
+static inline void HighwayHash128(const uint8_t *data, size_t size,
+                                  const uint64_t *key, uint64_t *hash) {
+  HighwayHashInline128(data, size, key, hash);
+}
+
+static inline void HighwayHash256(const uint8_t *data, size_t size,
+                                  const uint64_t *key, uint64_t *hash) {
+  HighwayHashInline256(data, size, key, hash);
+}
+
+static inline void HighwayHashKeyInit(HighwayHashKey *hkey,
+                                      const uint64_t *key) {
+  HighwayHashInlineKeyInit(hkey, key);
+}
+
+static inline uint64_t HighwayHash64WithKey(const uint8_t *data, size_t size,
+                                            const HighwayHashKey *hkey) {
+  return HighwayHashInline64WithKey(data, size, hkey);
+}
+
+static inline void HighwayHash128WithKey(const uint8_t *data, size_t size,
+                                         const HighwayHashKey *hkey,
+                                         uint64_t *hash) {
+  HighwayHashInline128WithKey(data, size, hkey, hash);
+}
+
+static inline void HighwayHash256WithKey(const uint8_t *data, size_t size,
+                                         const HighwayHashKey *hkey,
+                                         uint64_t *hash) {
+  HighwayHashInline256WithKey(data, size, hkey, hash);
+}
+#endif
+
+#if defined(__cplusplus) || defined(c_plusplus)
+} /* extern "C" */
+#endif
+
+#endif // C_HIGHWAYHASH_INLINE_H_
@@ -0,0 +1,78 @@
+#ifndef C_HIGHWAYHASH_MAP_H_
+#define C_HIGHWAYHASH_MAP_H_
+
+#include "hh_c/highwayhash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Hash map: open addressing with 16-slot groups                              */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+Keys are byte strings hashed with HighwayHash64 under a per-map key, so an
+attacker who does not know that key cannot force collisions. The low 7 bits
+of the hash go into one control byte per slot, the rest pick the first group
+to probe. A lookup compares the 16 control bytes of a group at once and only
+compares keys on a control byte match.
+
+Every group counts the keys that had to move past it because it was full.
+A lookup stops at the first group without such keys, and erasing a key
+decrements the counts along its probe sequence, so no tombstones are needed
+and lookups never slow down after many erasures.
+
+The map does not copy keys, they must stay valid while they are in the map.
+*/
+
+typedef struct {
+  const uint8_t *key;
+  size_t key_size;
+  void *value;
+} HighwayHashMapEntry;
+
+typedef struct {
+  HighwayHashKey hkey;
+  uint8_t *ctrl;    /* 16 control bytes per group */
+  size_t *overflow; /* per group, keys probed past it */
+  HighwayHashMapEntry *slots;
+  size_t group_mask; /* number of groups - 1 */
+  size_t size;
+} HighwayHashMap;
+
+/* Initializes an empty map. key may be NULL to draw a random key from the
+   operating system. Returns 0 on success and -1 if no randomness is
+   available. */
+int HighwayHashMapInit(HighwayHashMap *map, const uint64_t *key);
+
+/* Frees the map's memory, not the keys or values */
+void HighwayHashMapFree(HighwayHashMap *map);
+
+/* Returns the address of the value stored for key, or NULL if it is absent.
+   The address is valid until the next insertion. */
+void **HighwayHashMapFind(const HighwayHashMap *map, const uint8_t *key,
+                          size_t key_size);
+
+/* Stores value for key, replacing an existing value. Returns 1 if the key
+   was added, 0 if it was already present and -1 if out of memory. */
+int HighwayHashMapInsert(HighwayHashMap *map, const uint8_t *key,
+                         size_t key_size, void *value);
+
+/* Returns 1 if key was removed and 0 if it was absent */
+int HighwayHashMapErase(HighwayHashMap *map, const uint8_t *key,
+                        size_t key_size);
+
+/* Iterates over all entries in no particular order. Start with *iter = 0,
+   returns NULL at the end. The map must not be modified meanwhile. */
+const HighwayHashMapEntry *HighwayHashMapNext(const HighwayHashMap *map,
+                                              size_t *iter);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+} /* extern "C" */
+#endif
+
+#endif // C_HIGHWAYHASH_MAP_H_
@@ -0,0 +1,70 @@
+#ifndef C_HIGHWAYHASH_SHARD_H_
+#define C_HIGHWAYHASH_SHARD_H_
+
+#include "hh_c/highwayhash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Sharding: rendezvous and jump consistent hashing                           */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+Rendezvous (highest random weight) hashing gives node n the score
+HighwayHash64(data, size, node_key[n]) for a request key and routes the
+request to the node with the highest score. Node keys are derived from the
+secret key K and the 64-bit node ids: node_key[n] is HighwayHash256 of the
+node id as 8 little-endian bytes under K. Adding or removing a node only
+moves the requests that node wins or won, and the ids, not the order of the
+nodes, decide the winner.
+
+The scores of one request are computed with HighwayHash64MultiKey, which
+reads each packet of the request key once per group of nodes and keeps
+their states in flight together.
+*/
+
+typedef struct {
+  uint64_t *node_keys; /* 4 words per node */
+  uint64_t *node_ids;
+  size_t num_nodes;
+} HighwayHashRendezvous;
+
+/* Derives the keys of num_nodes nodes, which must be at least 1. Returns 0
+   on success and -1 if num_nodes is 0 or out of memory. */
+int HighwayHashRendezvousInit(HighwayHashRendezvous *hrw, const uint64_t *key,
+                              const uint64_t *node_ids, size_t num_nodes);
+
+void HighwayHashRendezvousFree(HighwayHashRendezvous *hrw);
+
+/* Writes the num_nodes scores of a request key, in node order */
+void HighwayHashRendezvousScores(const HighwayHashRendezvous *hrw,
+                                 const uint8_t *data, size_t size,
+                                 uint64_t *scores);
+
+/* Returns the index of the node with the highest score. Equal scores go to
+   the node with the smaller id. */
+size_t HighwayHashRendezvousLookup(const HighwayHashRendezvous *hrw,
+                                   const uint8_t *data, size_t size);
+
+/* Jump consistent hash (Lamping and Veach): maps hash to a bucket in
+   [0, num_buckets), num_buckets at least 1. Growing from n to n + 1 buckets
+   moves a 1 / (n + 1) share of the hashes, all into the new bucket. It is
+   only as hard to steer as hash is, so feed it keyed hashes. */
+uint32_t HighwayHashJump(uint64_t hash, uint32_t num_buckets);
+
+/* HighwayHashJump of the request key's HighwayHash64WithKey. Buckets are
+   numbered, not named, so only the last bucket can be removed. */
+uint32_t HighwayHashJumpShard(const uint8_t *data, size_t size,
+                              const HighwayHashKey *hkey,
+                              uint32_t num_buckets);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+} /* extern "C" */
+#endif
+
+#endif // C_HIGHWAYHASH_SHARD_H_
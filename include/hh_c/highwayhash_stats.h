@@ -0,0 +1,65 @@
+#ifndef C_HIGHWAYHASH_STATS_H_
+#define C_HIGHWAYHASH_STATS_H_
+
+#include <stdint.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Usage statistics, compiled in with -Dstats=counters or -Dstats=cycles      */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+Every thread counts into its own block, so recording never contends. A
+snapshot adds up the blocks of all live threads and those of threads that
+have exited. Without the meson option the library records nothing and the
+functions below report zeros.
+*/
+
+typedef enum {
+  HIGHWAYHASH_STATS_HASH64,  /* HighwayHash64, HighwayHash64WithKey */
+  HIGHWAYHASH_STATS_HASH128, /* HighwayHash128, HighwayHash128WithKey */
+  HIGHWAYHASH_STATS_HASH256, /* HighwayHash256, HighwayHash256WithKey */
+  HIGHWAYHASH_STATS_CAT_APPEND,
+  HIGHWAYHASH_STATS_CAT_FINISH64,
+  HIGHWAYHASH_STATS_CAT_FINISH128,
+  HIGHWAYHASH_STATS_CAT_FINISH256,
+  HIGHWAYHASH_STATS_FINALIZE64,
+  HIGHWAYHASH_STATS_FINALIZE128,
+  HIGHWAYHASH_STATS_FINALIZE256,
+  HIGHWAYHASH_STATS_COUNT
+} HighwayHashStatsFunction;
+
+typedef struct {
+  uint64_t calls;
+  uint64_t bytes;
+  /* TSC cycles spent in the calls, only counted with -Dstats=cycles */
+  uint64_t cycles;
+  /* sizes[0] counts empty inputs and finalizations, sizes[k] inputs of
+     2^(k-1) to 2^k - 1 bytes */
+  uint64_t sizes[65];
+} HighwayHashStatsCounters;
+
+typedef struct {
+  HighwayHashStatsCounters functions[HIGHWAYHASH_STATS_COUNT];
+} HighwayHashStats;
+
+/* 0 if compiled out, 1 with counters, 2 with counters and cycles */
+int HighwayHashStatsLevel(void);
+
+/* Counts since the last reset, summed over all threads */
+void HighwayHashStatsSnapshot(HighwayHashStats *stats);
+
+/* Starts counting from zero again, for all threads */
+void HighwayHashStatsReset(void);
+
+/* Returns a short lowercase name such as "hash64" */
+const char *HighwayHashStatsFunctionName(HighwayHashStatsFunction function);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+} /* extern "C" */
+#endif
+
+#endif // C_HIGHWAYHASH_STATS_H_
@@ -0,0 +1,63 @@
+#ifndef C_HIGHWAYHASH_TREE_H_
+#define C_HIGHWAYHASH_TREE_H_
+
+#include "hh_c/highwayhash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Tree mode: parallel hashing of large buffers                               */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/*
+Tree hashes are a separate output domain, unrelated to HighwayHash64 etc. of
+the same data. For a key K, leaf size L and input of size N:
+
+  - The input is split into leaves of L bytes, the last one may be shorter.
+    An empty input is a single empty leaf.
+  - Leaf i is hashed with HighwayHash256 under the key
+    K ^ kHighwayHashTreeLeafDomain, giving a 32-byte digest stored as four
+    little-endian 64-bit words.
+  - The root is HighwayHash64/128/256 under the key
+    K ^ kHighwayHashTreeRootDomain of all leaf digests in order, followed by
+    N and L as little-endian 64-bit words.
+
+The result depends on K, L and the data only, never on the thread count.
+*/
+
+#define HIGHWAYHASH_TREE_DEFAULT_LEAF_SIZE ((size_t)1 << 20)
+
+typedef struct {
+  /* Bytes per leaf, 0 selects HIGHWAYHASH_TREE_DEFAULT_LEAF_SIZE. Multiples
+     of 32 avoid a remainder per leaf. */
+  size_t leaf_size;
+  /* Threads hashing leaves, including the caller. 0 uses one per online
+     CPU. */
+  unsigned num_threads;
+} HighwayHashTreeOptions;
+
+/* Domain separation constants XORed into the caller's key */
+extern const uint64_t kHighwayHashTreeLeafDomain[4];
+extern const uint64_t kHighwayHashTreeRootDomain[4];
+
+/* options may be NULL for the defaults */
+uint64_t HighwayHashTree64(const uint8_t *data, size_t size,
+                           const uint64_t *key,
+                           const HighwayHashTreeOptions *options);
+
+void HighwayHashTree128(const uint8_t *data, size_t size, const uint64_t *key,
+                        const HighwayHashTreeOptions *options, uint64_t *hash);
+
+void HighwayHashTree256(const uint8_t *data, size_t size, const uint64_t *key,
+                        const HighwayHashTreeOptions *options, uint64_t *hash);
+
+#if defined(__cplusplus) || defined(c_plusplus)
+} /* extern "C" */
+#endif
+
+#endif // C_HIGHWAYHASH_TREE_H_
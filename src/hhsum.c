@@ -0,0 +1,624 @@
+#define _DEFAULT_SOURCE
+#include "hh_c/highwayhash.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+hhsum prints or checks HighwayHash checksums, in the format of sha256sum:
+
+  hhsum [-b 64|128|256] [-k KEY] [-j THREADS] [-r] [FILE...]
+  hhsum -c [-k KEY] [-j THREADS] [CHECKFILE...]
+
+The long forms are --bits, --key, --jobs, --recursive and --check.
+
+Each line is the hash as 16, 32 or 64 hex digits (hash[0] first, each word
+printed as a big-endian number), two spaces and the path. KEY is 64 hex
+digits read as four 64-bit words, first word first; the default key is the
+bytes 0x00..0x1f in memory order. With no FILE, or when FILE is -, standard
+input is read. -r descends into directories, but not through symbolic
+links to directories below the named ones.
+
+Files are spread over a work-stealing thread pool. Large files are mapped,
+small ones are read and hashed with the batch API a few at a time, and
+lines are printed in input order as soon as they are ready.
+*/
+
+#define kMmapThreshold ((off_t)1 << 20)
+#define kReadChunk (1u << 20)
+#define kBatch 16
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Entries and results                                                        */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+enum { kPending, kHashed, kFailed };
+
+typedef struct {
+  char *path;
+  int bits;
+  int status;
+  int error;
+  uint64_t hash[4];
+  uint64_t expected[4]; /* --check only */
+} Entry;
+
+typedef struct {
+  Entry *entries;
+  size_t num;
+  size_t capacity;
+} EntryList;
+
+static void AddEntry(EntryList *list, const char *path, int bits) {
+  if (list->num == list->capacity) {
+    list->capacity = list->capacity ? 2 * list->capacity : 1024;
+    list->entries = realloc(list->entries, list->capacity * sizeof(Entry));
+    if (list->entries == NULL) {
+      fprintf(stderr, "hhsum: out of memory\n");
+      exit(2);
+    }
+  }
+  Entry *entry = &list->entries[list->num++];
+  memset(entry, 0, sizeof(*entry));
+  entry->path = strdup(path);
+  entry->bits = bits;
+  if (entry->path == NULL) {
+    fprintf(stderr, "hhsum: out of memory\n");
+    exit(2);
+  }
+}
+
+static void AddPath(EntryList *list, const char *path, int bits,
+                    int recursive) {
+  struct stat st;
+  if (recursive && strcmp(path, "-") != 0 && stat(path, &st) == 0 &&
+      S_ISDIR(st.st_mode)) {
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+      AddEntry(list, path, bits);
+      return;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+      if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+        continue;
+      }
+      const size_t len = strlen(path) + strlen(ent->d_name) + 2;
+      char *child = malloc(len);
+      if (child == NULL) {
+        fprintf(stderr, "hhsum: out of memory\n");
+        exit(2);
+      }
+      snprintf(child, len, "%s%s%s", path,
+               path[strlen(path) - 1] == '/' ? "" : "/", ent->d_name);
+      // Links to directories are not followed, so a link to an ancestor
+      // cannot make the walk revisit files or loop.
+      if (lstat(child, &st) == 0 && S_ISLNK(st.st_mode) &&
+          stat(child, &st) == 0 && S_ISDIR(st.st_mode)) {
+        free(child);
+        continue;
+      }
+      AddPath(list, child, bits, recursive);
+      free(child);
+    }
+    closedir(dir);
+    return;
+  }
+  AddEntry(list, path, bits);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Hashing one file                                                           */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static uint64_t key[4] = {0x0706050403020100, 0x0F0E0D0C0B0A0908,
+                          0x1716151413121110, 0x1F1E1D1C1B1A1918};
+
+static void HashBuffer(const uint8_t *data, size_t size, int bits,
+                       uint64_t *hash) {
+  if (bits == 64) {
+    hash[0] = HighwayHash64(data, size, key);
+  } else if (bits == 128) {
+    HighwayHash128(data, size, key, hash);
+  } else {
+    HighwayHash256(data, size, key, hash);
+  }
+}
+
+static void FinishCat(const HighwayHashCat *cat, int bits, uint64_t *hash) {
+  if (bits == 64) {
+    hash[0] = HighwayHashCatFinish64(cat);
+  } else if (bits == 128) {
+    HighwayHashCatFinish128(cat, hash);
+  } else {
+    HighwayHashCatFinish256(cat, hash);
+  }
+}
+
+/* For pipes, devices and anything that cannot be mapped. */
+static int HashStream(int fd, int bits, uint64_t *hash, uint8_t *buffer) {
+  HighwayHashCat cat;
+  HighwayHashCatStart(&cat, key);
+  for (;;) {
+    const ssize_t got = read(fd, buffer, kReadChunk);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    if (got == 0) {
+      break;
+    }
+    HighwayHashCatAppend(&cat, buffer, (size_t)got);
+  }
+  FinishCat(&cat, bits, hash);
+  return 0;
+}
+
+static int ReadAll(int fd, uint8_t *dst, size_t size, size_t *got) {
+  *got = 0;
+  while (*got < size) {
+    const ssize_t n = read(fd, dst + *got, size - *got);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    if (n == 0) {
+      break;
+    }
+    *got += (size_t)n;
+  }
+  return 0;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Work-stealing pool                                                         */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Each worker owns a contiguous range of entry indices and takes batches
+   from its front; an idle worker steals the back half of another range. */
+typedef struct {
+  pthread_mutex_t lock;
+  size_t begin;
+  size_t end;
+} Deque;
+
+typedef struct {
+  Entry *entries;
+  Deque *deques;
+  unsigned num_workers;
+  pthread_mutex_t done_lock;
+  pthread_cond_t done_cond;
+} Pool;
+
+typedef struct {
+  Pool *pool;
+  unsigned id;
+  uint8_t *buffer; /* kReadChunk bytes */
+  uint8_t *arena;  /* small files of the current batch */
+  size_t arena_capacity;
+} Worker;
+
+static int TakeOwn(Deque *deque, size_t *begin, size_t *end) {
+  pthread_mutex_lock(&deque->lock);
+  *begin = deque->begin;
+  *end = deque->end - deque->begin > kBatch ? deque->begin + kBatch
+                                            : deque->end;
+  deque->begin = *end;
+  pthread_mutex_unlock(&deque->lock);
+  return *begin < *end;
+}
+
+static int Steal(Pool *pool, unsigned thief) {
+  for (unsigned i = 1; i < pool->num_workers; i++) {
+    Deque *victim = &pool->deques[(thief + i) % pool->num_workers];
+    pthread_mutex_lock(&victim->lock);
+    const size_t available = victim->end - victim->begin;
+    if (available == 0) {
+      pthread_mutex_unlock(&victim->lock);
+      continue;
+    }
+    const size_t mid = victim->end - (available + 1) / 2;
+    const size_t end = victim->end;
+    victim->end = mid;
+    pthread_mutex_unlock(&victim->lock);
+
+    Deque *own = &pool->deques[thief];
+    pthread_mutex_lock(&own->lock);
+    own->begin = mid;
+    own->end = end;
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+  }
+  return 0;
+}
+
+/* Publishes the result, the printing thread polls status. */
+static void Complete(Entry *entry, int error) {
+  entry->error = error;
+  __atomic_store_n(&entry->status, error ? kFailed : kHashed,
+                   __ATOMIC_RELEASE);
+}
+
+/* Hashes the entries [begin, end). Small regular files are collected in the
+   arena and hashed together, everything else is hashed on its own. */
+static void HashRange(Worker *worker, size_t begin, size_t end) {
+  Entry *entries = worker->pool->entries;
+  const uint8_t *ptrs[kBatch];
+  size_t sizes[kBatch];
+  size_t offsets[kBatch];
+  size_t members[kBatch];
+  size_t num_small[3] = {0, 0, 0};
+  size_t used = 0;
+  size_t num = 0;
+
+  for (size_t i = begin; i < end; i++) {
+    Entry *entry = &entries[i];
+    const int is_stdin = strcmp(entry->path, "-") == 0;
+    const int fd = is_stdin ? STDIN_FILENO : open(entry->path, O_RDONLY);
+    if (fd < 0) {
+      Complete(entry, errno);
+      continue;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      Complete(entry, errno);
+    } else if (S_ISDIR(st.st_mode)) {
+      Complete(entry, EISDIR);
+    } else if (!S_ISREG(st.st_mode)) {
+      Complete(entry, HashStream(fd, entry->bits, entry->hash, worker->buffer));
+    } else if (st.st_size >= kMmapThreshold) {
+      void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) {
+        Complete(entry,
+                 HashStream(fd, entry->bits, entry->hash, worker->buffer));
+      } else {
+        posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+        HashBuffer(map, (size_t)st.st_size, entry->bits, entry->hash);
+        munmap(map, (size_t)st.st_size);
+        Complete(entry, 0);
+      }
+    } else {
+      const size_t size = (size_t)st.st_size;
+      if (used + size > worker->arena_capacity) {
+        const size_t capacity = (used + size) * 2;
+        uint8_t *arena = realloc(worker->arena, capacity);
+        if (arena == NULL) {
+          Complete(entry, ENOMEM);
+          if (!is_stdin) {
+            close(fd);
+          }
+          continue;
+        }
+        worker->arena = arena;
+        worker->arena_capacity = capacity;
+      }
+      size_t got;
+      const int error = ReadAll(fd, worker->arena + used, size, &got);
+      if (error) {
+        Complete(entry, error);
+      } else {
+        offsets[num] = used;
+        sizes[num] = got;
+        members[num] = i;
+        num_small[entry->bits / 128]++;
+        num++;
+        used += got;
+      }
+    }
+    if (!is_stdin) {
+      close(fd);
+    }
+  }
+
+  // The arena may have moved while growing, so pointers are taken last.
+  for (size_t j = 0; j < num; j++) {
+    ptrs[j] = worker->arena + offsets[j];
+  }
+  if (num > 0 && num_small[0] == num) {
+    uint64_t hashes[kBatch];
+    HighwayHash64Batch(ptrs, sizes, num, key, hashes);
+    for (size_t j = 0; j < num; j++) {
+      entries[members[j]].hash[0] = hashes[j];
+    }
+  } else if (num > 0 && num_small[1] == num) {
+    uint64_t hashes[2 * kBatch];
+    HighwayHash128Batch(ptrs, sizes, num, key, hashes);
+    for (size_t j = 0; j < num; j++) {
+      entries[members[j]].hash[0] = hashes[2 * j];
+      entries[members[j]].hash[1] = hashes[2 * j + 1];
+    }
+  } else {
+    for (size_t j = 0; j < num; j++) {
+      HashBuffer(ptrs[j], sizes[j], entries[members[j]].bits,
+                 entries[members[j]].hash);
+    }
+  }
+  for (size_t j = 0; j < num; j++) {
+    Complete(&entries[members[j]], 0);
+  }
+}
+
+static void *WorkerMain(void *arg) {
+  Worker *worker = arg;
+  Pool *pool = worker->pool;
+  size_t begin;
+  size_t end;
+  for (;;) {
+    if (!TakeOwn(&pool->deques[worker->id], &begin, &end)) {
+      if (Steal(pool, worker->id)) {
+        continue;
+      }
+      break;
+    }
+    HashRange(worker, begin, end);
+    pthread_mutex_lock(&pool->done_lock);
+    pthread_cond_broadcast(&pool->done_cond);
+    pthread_mutex_unlock(&pool->done_lock);
+  }
+  return NULL;
+}
+
+/* Hashes every entry, calling report for each in order as it completes.
+   Returns the number of entries report flagged as bad. */
+static size_t RunPool(EntryList *list, unsigned num_workers,
+                      int (*report)(const Entry *)) {
+  Pool pool;
+  pool.entries = list->entries;
+  pool.num_workers = num_workers;
+  pool.deques = calloc(num_workers, sizeof(Deque));
+  Worker *workers = calloc(num_workers, sizeof(Worker));
+  pthread_t *threads = calloc(num_workers, sizeof(pthread_t));
+  if (pool.deques == NULL || workers == NULL || threads == NULL) {
+    fprintf(stderr, "hhsum: out of memory\n");
+    exit(2);
+  }
+  pthread_mutex_init(&pool.done_lock, NULL);
+  pthread_cond_init(&pool.done_cond, NULL);
+  for (unsigned w = 0; w < num_workers; w++) {
+    pthread_mutex_init(&pool.deques[w].lock, NULL);
+    pool.deques[w].begin = list->num * w / num_workers;
+    pool.deques[w].end = list->num * (w + 1) / num_workers;
+    workers[w].pool = &pool;
+    workers[w].id = w;
+    workers[w].buffer = malloc(kReadChunk);
+    if (workers[w].buffer == NULL) {
+      fprintf(stderr, "hhsum: out of memory\n");
+      exit(2);
+    }
+  }
+  for (unsigned w = 0; w < num_workers; w++) {
+    if (pthread_create(&threads[w], NULL, WorkerMain, &workers[w]) != 0) {
+      fprintf(stderr, "hhsum: cannot start worker threads\n");
+      exit(2);
+    }
+  }
+
+  size_t bad = 0;
+  for (size_t i = 0; i < list->num; i++) {
+    pthread_mutex_lock(&pool.done_lock);
+    while (__atomic_load_n(&list->entries[i].status, __ATOMIC_ACQUIRE) ==
+           kPending) {
+      pthread_cond_wait(&pool.done_cond, &pool.done_lock);
+    }
+    pthread_mutex_unlock(&pool.done_lock);
+    bad += report(&list->entries[i]) != 0;
+  }
+
+  for (unsigned w = 0; w < num_workers; w++) {
+    pthread_join(threads[w], NULL);
+    pthread_mutex_destroy(&pool.deques[w].lock);
+    free(workers[w].buffer);
+    free(workers[w].arena);
+  }
+  pthread_cond_destroy(&pool.done_cond);
+  pthread_mutex_destroy(&pool.done_lock);
+  free(threads);
+  free(workers);
+  free(pool.deques);
+  return bad;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Printing and checking                                                      */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static int PrintSum(const Entry *entry) {
+  if (entry->status == kFailed) {
+    fprintf(stderr, "hhsum: %s: %s\n", entry->path, strerror(entry->error));
+    return 1;
+  }
+  for (int i = 0; i < entry->bits / 64; i++) {
+    printf("%016" PRIx64, entry->hash[i]);
+  }
+  printf("  %s\n", entry->path);
+  return 0;
+}
+
+static size_t num_unreadable = 0;
+
+static int PrintCheck(const Entry *entry) {
+  if (entry->status == kFailed) {
+    printf("%s: FAILED open or read\n", entry->path);
+    num_unreadable++;
+    return 0;
+  }
+  const int ok = memcmp(entry->hash, entry->expected,
+                        (size_t)entry->bits / 8) == 0;
+  printf("%s: %s\n", entry->path, ok ? "OK" : "FAILED");
+  return !ok;
+}
+
+static int ParseHex(const char *hex, size_t digits, uint64_t *words) {
+  for (size_t w = 0; w < digits / 16; w++) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 16; i++) {
+      const char c = hex[16 * w + i];
+      int nibble;
+      if (c >= '0' && c <= '9') {
+        nibble = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        nibble = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        nibble = c - 'A' + 10;
+      } else {
+        return -1;
+      }
+      value = (value << 4) | (uint64_t)nibble;
+    }
+    words[w] = value;
+  }
+  return 0;
+}
+
+/* Reads "<hex>  <path>" lines, the hex length selects the width. Returns the
+   number of malformed lines. */
+static size_t ReadCheckFile(FILE *file, EntryList *list) {
+  char *line = NULL;
+  size_t capacity = 0;
+  size_t malformed = 0;
+  ssize_t len;
+  while ((len = getline(&line, &capacity, file)) > 0) {
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+      line[--len] = '\0';
+    }
+    size_t digits = 0;
+    while (digits < (size_t)len && line[digits] != ' ') {
+      digits++;
+    }
+    uint64_t expected[4];
+    if ((digits != 16 && digits != 32 && digits != 64) ||
+        (size_t)len < digits + 3 ||
+        (line[digits + 1] != ' ' && line[digits + 1] != '*') ||
+        ParseHex(line, digits, expected) != 0) {
+      malformed++;
+      continue;
+    }
+    // "  path" for text mode, " *path" for binary mode.
+    AddEntry(list, line + digits + 2, (int)digits * 4);
+    memcpy(list->entries[list->num - 1].expected, expected, digits / 2);
+  }
+  free(line);
+  return malformed;
+}
+
+static void Usage(void) {
+  fprintf(stderr,
+          "usage: hhsum [-b 64|128|256] [-k KEY] [-j THREADS] [-r] [FILE...]\n"
+          "       hhsum -c [-k KEY] [-j THREADS] [CHECKFILE...]\n"
+          "long forms: --bits, --key, --jobs, --recursive, --check\n");
+  exit(2);
+}
+
+static const struct option kLongOptions[] = {
+    {"bits", required_argument, NULL, 'b'},
+    {"check", no_argument, NULL, 'c'},
+    {"key", required_argument, NULL, 'k'},
+    {"jobs", required_argument, NULL, 'j'},
+    {"recursive", no_argument, NULL, 'r'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}};
+
+int main(int argc, char **argv) {
+  int bits = 64;
+  int check = 0;
+  int recursive = 0;
+  long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+  while ((opt = getopt_long(argc, argv, "b:ck:j:rh", kLongOptions, NULL)) !=
+         -1) {
+    switch (opt) {
+    case 'b':
+      bits = atoi(optarg);
+      if (bits != 64 && bits != 128 && bits != 256) {
+        Usage();
+      }
+      break;
+    case 'c':
+      check = 1;
+      break;
+    case 'k':
+      if (strlen(optarg) != 64 || ParseHex(optarg, 64, key) != 0) {
+        fprintf(stderr, "hhsum: the key must be 64 hex digits\n");
+        return 2;
+      }
+      break;
+    case 'j':
+      num_workers = atol(optarg);
+      break;
+    case 'r':
+      recursive = 1;
+      break;
+    default:
+      Usage();
+    }
+  }
+  if (num_workers < 1) {
+    num_workers = 1;
+  }
+
+  EntryList list = {NULL, 0, 0};
+  size_t malformed = 0;
+  if (check) {
+    if (optind == argc) {
+      malformed += ReadCheckFile(stdin, &list);
+    }
+    for (int i = optind; i < argc; i++) {
+      FILE *file = strcmp(argv[i], "-") == 0 ? stdin : fopen(argv[i], "r");
+      if (file == NULL) {
+        fprintf(stderr, "hhsum: %s: %s\n", argv[i], strerror(errno));
+        return 1;
+      }
+      malformed += ReadCheckFile(file, &list);
+      if (file != stdin) {
+        fclose(file);
+      }
+    }
+  } else {
+    if (optind == argc) {
+      AddEntry(&list, "-", bits);
+    }
+    for (int i = optind; i < argc; i++) {
+      AddPath(&list, argv[i], bits, recursive);
+    }
+  }
+
+  if ((size_t)num_workers > list.num) {
+    num_workers = list.num > 0 ? (long)list.num : 1;
+  }
+  const size_t bad =
+      RunPool(&list, (unsigned)num_workers, check ? PrintCheck : PrintSum);
+
+  if (check) {
+    if (malformed) {
+      fprintf(stderr, "hhsum: WARNING: %zu lines are improperly formatted\n",
+              malformed);
+    }
+    if (num_unreadable) {
+      fprintf(stderr, "hhsum: WARNING: %zu listed files could not be read\n",
+              num_unreadable);
+    }
+    if (bad) {
+      fprintf(stderr, "hhsum: WARNING: %zu computed checksums did NOT match\n",
+              bad);
+    }
+  }
+  for (size_t i = 0; i < list.num; i++) {
+    free(list.entries[i].path);
+  }
+  free(list.entries);
+  return bad || num_unreadable || malformed ? 1 : 0;
+}
@@ -0,0 +1,61 @@
+#!/bin/sh
+# End-to-end test of hhsum: usage hhsum_test.sh HHSUM FIXTURE, where FIXTURE
+# holds the bytes 0..63. Covers a known answer, mapped against streamed
+# input, the --check round trip of a tree with many small files hashed in
+# batches on several threads, with long and short options, and -r over
+# symbolic link loops.
+set -eu
+
+hhsum=$1
+fixture=$2
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+fail() {
+  echo "hhsum_test: $*" >&2
+  exit 1
+}
+
+# kExpected64[64] of hh_c_test: the default key is the bytes 0x00..0x1f.
+[ "$("$hhsum" "$fixture")" = "75542c5d4cd2a6ff  $fixture" ] ||
+  fail "known answer"
+
+mkdir -p "$tmp/tree/sub/deeper"
+cp "$fixture" "$tmp/tree/bytes64.bin"
+: >"$tmp/tree/empty"
+# Above the 1 MiB mapping threshold, ending in a partial packet
+yes hhsum | head -c 3000001 >"$tmp/tree/big"
+i=0
+while [ $i -lt 40 ]; do
+  printf 'small file %d\n' $i >"$tmp/tree/sub/small$i"
+  i=$((i + 1))
+done
+ln -s .. "$tmp/tree/sub/loop"
+ln -s ../.. "$tmp/tree/sub/deeper/loop"
+ln -s ../big "$tmp/tree/sub/big_link"
+num_files=44
+
+for bits in 64 128 256; do
+  "$hhsum" -b $bits "$tmp/tree/big" | cut -d' ' -f1 >"$tmp/mapped"
+  "$hhsum" -b $bits - <"$tmp/tree/big" | cut -d' ' -f1 >"$tmp/streamed"
+  cmp -s "$tmp/mapped" "$tmp/streamed" || fail "$bits: mapped != streamed"
+
+  "$hhsum" --recursive --bits $bits --jobs 4 "$tmp/tree" >"$tmp/sums" ||
+    fail "$bits: --recursive failed"
+  [ "$(wc -l <"$tmp/sums")" -eq $num_files ] || fail "$bits: file count"
+  ! grep -q /loop "$tmp/sums" || fail "$bits: followed a directory link"
+  "$hhsum" -r -b $bits -j 1 "$tmp/tree" | cmp -s - "$tmp/sums" ||
+    fail "$bits: thread count changed the output"
+  "$hhsum" --check --jobs 4 "$tmp/sums" >/dev/null ||
+    fail "$bits: --check failed"
+  "$hhsum" -c -j 2 "$tmp/sums" >/dev/null || fail "$bits: -c failed"
+done
+
+echo changed >>"$tmp/tree/sub/small7"
+if "$hhsum" --check "$tmp/sums" >"$tmp/check" 2>/dev/null; then
+  fail "--check missed a changed file"
+fi
+grep -qx "$tmp/tree/sub/small7: FAILED" "$tmp/check" ||
+  fail "--check did not name the changed file"
+[ "$(grep -c ': OK$' "$tmp/check")" -eq $((num_files - 1)) ] ||
+  fail "--check OK count"
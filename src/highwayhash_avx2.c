@@ -1,5 +1,4 @@
-#define HIGHWAYHASH_AVX2
-#include "hh_c/highwayhash.h"
+#include "highwayhash_backend.h"
 
 #include <emmintrin.h>
 #include <immintrin.h>
@@ -9,12 +8,36 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* The state lives in registers while a message is processed and is only
+   spilled to the backend-neutral HighwayHashState at API boundaries. */
+typedef struct {
+  __m256i v0;
+  __m256i v1;
+  __m256i mul0;
+  __m256i mul1;
+} InternalState;
+
 /*////////////////////////////////////////////////////////////////////////////*/
 /* Internal implementation                                                    */
 /*////////////////////////////////////////////////////////////////////////////*/
 
-// Verified.
-static inline void InternalHighwayHashReset(HighwayHashState *restrict state,
+static inline void InternalLoadState(InternalState *restrict state,
+                                     const HighwayHashState *restrict src) {
+  state->v0 = _mm256_loadu_si256((const __m256i_u *)src->v0);
+  state->v1 = _mm256_loadu_si256((const __m256i_u *)src->v1);
+  state->mul0 = _mm256_loadu_si256((const __m256i_u *)src->mul0);
+  state->mul1 = _mm256_loadu_si256((const __m256i_u *)src->mul1);
+}
+
+static inline void InternalStoreState(HighwayHashState *restrict dst,
+                                      const InternalState *restrict state) {
+  _mm256_storeu_si256((__m256i_u *)dst->v0, state->v0);
+  _mm256_storeu_si256((__m256i_u *)dst->v1, state->v1);
+  _mm256_storeu_si256((__m256i_u *)dst->mul0, state->mul0);
+  _mm256_storeu_si256((__m256i_u *)dst->mul1, state->mul1);
+}
+
+static inline void InternalHighwayHashReset(InternalState *restrict state,
                                             const __m256i *key) {
   alignas(alignof(__m256i))
       const uint64_t init_mul0[] = {0xdbe6d5d5fe4cce2f, 0xa4093822299f31d0,
@@ -30,7 +53,6 @@ static inline void InternalHighwayHashReset(HighwayHashState *restrict state,
                                                _mm256_slli_epi64(*key, 32)));
 }
 
-// TODO: Verify that this matches the portable implementation.
 static inline void InternalZipperMergeAndAdd(__m256i *restrict va,
                                              const __m256i *restrict vb) {
   const long long hi = 0x070806090D0A040B;
@@ -39,90 +61,124 @@ static inline void InternalZipperMergeAndAdd(__m256i *restrict va,
       *va, _mm256_shuffle_epi8(*vb, _mm256_set_epi64x(hi, lo, hi, lo)));
 }
 
-static void InternalUpdate(HighwayHashState *restrict state,
-                           const __m256i *restrict lanes) {
+static inline void InternalUpdate(InternalState *restrict state,
+                                  const __m256i *restrict lanes) {
   // state->v1 += state->mul0 + lanes
-  state->v1 = _mm256_add_epi64(state->mul0, *lanes);
+  state->v1 =
+      _mm256_add_epi64(state->v1, _mm256_add_epi64(state->mul0, *lanes));
 
   // state->mul0 ^= (state->v1 & 0xffffffff) * (state->v0 >> 32)
   state->mul0 = _mm256_xor_si256(
       state->mul0,
-      _mm256_mul_epi32(
-          _mm256_and_si256(state->v1, _mm256_set1_epi64x(0xffffffff)),
-          _mm256_srli_epi64(state->v0, 32)));
+      _mm256_mul_epu32(state->v1, _mm256_srli_epi64(state->v0, 32)));
 
   state->v0 = _mm256_add_epi64(state->v0, state->mul1);
 
   // state->mul1 ^= (state->v0 & 0xffffffff) * (state->v1 >> 32)
-  state->mul0 = _mm256_xor_si256(
-      state->mul0,
-      _mm256_mul_epi32(
-          _mm256_and_si256(state->v0, _mm256_set1_epi64x(0xffffffff)),
-          _mm256_srli_epi64(state->v1, 32)));
+  state->mul1 = _mm256_xor_si256(
+      state->mul1,
+      _mm256_mul_epu32(state->v0, _mm256_srli_epi64(state->v1, 32)));
 
   InternalZipperMergeAndAdd(&state->v0, &state->v1);
   InternalZipperMergeAndAdd(&state->v1, &state->v0);
 }
 
-static void InternalHighwayHashUpdatePacket(HighwayHashState *restrict state,
-                                            const __m256i *restrict packet) {
-  const long long hi = 0x08090a0b0c0d0e0f;
-  const long long lo = 0x0001020304050607;
-
-  __m256i temp =
-      _mm256_shuffle_epi8(*packet, _mm256_set_epi64x(hi, lo, hi, lo));
+static inline void
+InternalHighwayHashUpdatePacket(InternalState *restrict state,
+                                const uint8_t *restrict packet) {
+  // Lanes are little-endian, which is also the native byte order here.
+  __m256i temp = _mm256_loadu_si256((const __m256i_u *)packet);
   InternalUpdate(state, &temp);
 }
 
 static inline __m256i InternalRotate32By(const __m256i *restrict lanes,
                                          const __m256i *restrict count) {
-  return _mm256_or_si256(_mm256_sllv_epi32(*lanes, *count),
-                         _mm256_srlv_epi32(*lanes, 32 - *count));
+  return _mm256_or_si256(
+      _mm256_sllv_epi32(*lanes, *count),
+      _mm256_srlv_epi32(*lanes,
+                        _mm256_sub_epi32(_mm256_set1_epi32(32), *count)));
 }
 
-static inline void
-InternalHighwayHashUpdateRemainder(HighwayHashState *restrict state,
-                                   const __m256i *bytes, const int size_mod32) {
-  const size_t size_mod4 = size_mod32 & 3;
-  const uint8_t *remainder = (const uint8_t *)bytes + (size_mod32 & ~3);
-  const __m256i size_mod32_256 = _mm256_set1_epi32(size_mod32);
+static inline void InternalInjectSize(InternalState *restrict state,
+                                      const size_t size_mod32) {
+  const __m256i size_mod32_256 = _mm256_set1_epi32((int)size_mod32);
 
   state->v0 = _mm256_add_epi64(state->v0, size_mod32_256);
 
-  InternalRotate32By(&state->v1, &size_mod32_256);
+  state->v1 = InternalRotate32By(&state->v1, &size_mod32_256);
+}
 
-  alignas(alignof(__m256i)) uint8_t packet[32];
-  for (int i = 0; i < remainder - (const uint8_t *)bytes; i++) {
-    packet[i] = ((const uint8_t *)bytes)[i];
+/* Returns the last four bytes of a remainder that has a partial word or is
+   at least 16 bytes long, without reading outside of it. */
+static inline uint32_t InternalLoadLast4(const uint8_t *restrict bytes,
+                                         const size_t size_mod32) {
+  if (size_mod32 >= 4) {
+    uint32_t last4;
+    memcpy(&last4, bytes + size_mod32 - 4, 4);
+    return last4;
   }
+  // Shorter inputs are placed at the same byte offsets they would have in
+  // a four byte load ending at the last byte.
+  const int shift = 8 * (4 - (int)size_mod32);
+  return ((uint32_t)bytes[0] << shift) |
+         ((uint32_t)bytes[size_mod32 >> 1] << (shift + 8 * (size_mod32 >> 1))) |
+         ((uint32_t)bytes[size_mod32 - 1] << 24);
+}
 
-  // TODO: Vectorize this.
-  if (size_mod32 & 16) { // size_mod32 >= 16
-    for (int i = 0; i < 4; i++) {
-      packet[28 + i] = remainder[i + size_mod4 - 4];
-    }
+/* Builds the zero-padded remainder packet of a size_mod32 byte tail */
+static inline __m256i InternalRemainderPacket(const uint8_t *restrict bytes,
+                                              const size_t size_mod32) {
+  const size_t size_mod4 = size_mod32 & 3;
+
+  // The whole 4-byte words. Masked-off words are never read, so this cannot
+  // fault even when the input ends right before an unmapped page.
+  const __m256i int_mask =
+      _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(size_mod32 >> 2)),
+                         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256i packet = _mm256_maskload_epi32((const int *)bytes, int_mask);
+
+  if (size_mod32 & 16) {
+    // The last four bytes go to bytes 28..31, which no whole word reaches.
+    packet = _mm256_insert_epi32(
+        packet, (int)InternalLoadLast4(bytes, size_mod32), 7);
   } else if (size_mod4) {
-    packet[16 + 0] = remainder[0];
-    packet[16 + 1] = remainder[size_mod4 >> 1];
-    packet[16 + 2] = remainder[size_mod4 - 1];
+    // Bytes 16..18 are the first, middle and last byte of the partial word,
+    // picked out of the last four bytes by one shuffle. The upper half of
+    // the packet is still zero.
+    const int first = 4 - (int)size_mod4;
+    const int index =
+        first | ((first + (int)(size_mod4 >> 1)) << 8) | (3 << 16) | ~0xFFFFFF;
+    const __m128i last4 =
+        _mm_cvtsi32_si128((int)InternalLoadLast4(bytes, size_mod32));
+    const __m128i tail =
+        _mm_shuffle_epi8(last4, _mm_setr_epi32(index, -1, -1, -1));
+    packet = _mm256_inserti128_si256(packet, tail, 1);
   }
+  return packet;
+}
 
-  InternalHighwayHashUpdatePacket(state, (__m256i *)packet);
+static inline void
+InternalHighwayHashUpdateRemainder(InternalState *restrict state,
+                                   const uint8_t *restrict bytes,
+                                   const size_t size_mod32) {
+  const __m256i packet = InternalRemainderPacket(bytes, size_mod32);
+  InternalInjectSize(state, size_mod32);
+  InternalUpdate(state, &packet);
 }
 
 static inline __m256i InternalPermute(const __m256i v) {
+  // Swaps the 128-bit halves and the 32-bit halves of every lane.
   return _mm256_permutevar8x32_epi32(v,
-                                     _mm256_set_epi32(5, 4, 7, 6, 1, 0, 3, 2));
+                                     _mm256_setr_epi32(5, 4, 7, 6, 1, 0, 3, 2));
 }
 
-static void InternalPermuteAndUpdate(HighwayHashState *restrict state) {
+static inline void InternalPermuteAndUpdate(InternalState *restrict state) {
   __m256i temp = InternalPermute(state->v0);
   InternalUpdate(state, &temp);
 }
 
-// Verified.
-static inline uint64_t InternalHighwayHashFinalize64(
-    HighwayHashState *restrict state) {
+static inline uint64_t
+InternalHighwayHashFinalize64(InternalState *restrict state) {
   for (int i = 0; i < 4; i++) {
     InternalPermuteAndUpdate(state);
   }
@@ -135,41 +191,35 @@ static inline uint64_t InternalHighwayHashFinalize64(
 }
 
 static inline __m128i
-InternalHighwayHashFinalize128(HighwayHashState *restrict state) {
+InternalHighwayHashFinalize128(InternalState *restrict state) {
   for (int i = 0; i < 6; i++) {
     InternalPermuteAndUpdate(state);
   }
   const __m256i sum0 = _mm256_add_epi64(state->v0, state->mul0);
   __m256i sum1 = _mm256_add_epi64(state->v1, state->mul1);
-  sum1 = _mm256_permute2f128_si256(sum1, sum1, 0x01);
+  sum1 = _mm256_permute2x128_si256(sum1, sum1, 0x01);
 
   return _mm256_castsi256_si128(_mm256_add_epi64(sum0, sum1));
 }
 
-static inline __m256i ModularReduction(const __m256i b32a32, __m256i b10a10) {
-  const __m256i ones = _mm256_set1_epi64x(-1);
-  const __m256i zero = _mm256_xor_si256(ones, ones);
-
-  const __m256i shifted1_unmasked = _mm256_add_epi64(b32a32, b32a32);
+// Each 128-bit half holds (a3, a2) in b32a32 and (a1, a0) in b10a10.
+static inline __m256i ModularReduction(const __m256i b32a32,
+                                       const __m256i b10a10) {
+  const __m256i mask = _mm256_setr_epi64x(-1, 0x3FFFFFFFFFFFFFFF, -1,
+                                          0x3FFFFFFFFFFFFFFF);
+  const __m256i x = _mm256_and_si256(b32a32, mask);
 
-  b10a10 = _mm256_xor_si256(
-      b10a10, _mm256_add_epi64(shifted1_unmasked, shifted1_unmasked));
-  b10a10 = _mm256_xor_si256(
-      b10a10, _mm256_unpacklo_epi64(zero, _mm256_srli_epi64(b32a32, 62)));
-  b10a10 = _mm256_xor_si256(
-      b10a10,
-      _mm256_xor_si256(
-          _mm256_and_si256(_mm256_slli_epi64(_mm256_slli_si256(ones, 8), 63),
-                           shifted1_unmasked),
-          ones));
-  b10a10 = _mm256_xor_si256(
-      b10a10, _mm256_unpacklo_epi64(zero, _mm256_srli_epi64(b32a32, 63)));
+  // 128-bit shifts: the bits shifted out of a2 are carried into a3.
+  const __m256i shifted1 = _mm256_or_si256(
+      _mm256_slli_epi64(x, 1), _mm256_slli_si256(_mm256_srli_epi64(x, 63), 8));
+  const __m256i shifted2 = _mm256_or_si256(
+      _mm256_slli_epi64(x, 2), _mm256_slli_si256(_mm256_srli_epi64(x, 62), 8));
 
-  return b10a10;
+  return _mm256_xor_si256(b10a10, _mm256_xor_si256(shifted1, shifted2));
 }
 
 static inline __m256i
-InternalHighwayHashFinalize256(HighwayHashState *restrict state) {
+InternalHighwayHashFinalize256(InternalState *restrict state) {
   for (int i = 0; i < 10; i++) {
     InternalPermuteAndUpdate(state);
   }
@@ -180,45 +230,303 @@ InternalHighwayHashFinalize256(HighwayHashState *restrict state) {
   return ModularReduction(sum1, sum0);
 }
 
+static inline void InternalProcessData(InternalState *restrict state,
+                                       const uint8_t *restrict data,
+                                       size_t size) {
+  size_t i = 0;
+  while (i + 32 <= size) {
+    InternalHighwayHashUpdatePacket(state, data + i);
+    i += 32;
+  }
+  if ((size & 31) != 0) {
+    InternalHighwayHashUpdateRemainder(state, data + i, size & 31);
+  }
+}
+
+static inline void InternalProcessAll(InternalState *restrict state,
+                                      const uint8_t *restrict data,
+                                      size_t size,
+                                      const uint64_t *restrict key) {
+  __m256i temp = _mm256_loadu_si256((const __m256i_u *)key);
+  InternalHighwayHashReset(state, &temp);
+  InternalProcessData(state, data, size);
+}
+
+static inline void InternalProcessLanes(InternalState *restrict state,
+                                        const __m256i lanes,
+                                        size_t size_mod32,
+                                        const uint64_t *restrict key) {
+  __m256i temp = _mm256_loadu_si256((const __m256i_u *)key);
+  InternalHighwayHashReset(state, &temp);
+  if (size_mod32 != 0) {
+    InternalInjectSize(state, size_mod32);
+  }
+  InternalUpdate(state, &lanes);
+}
+
+/* Absorbs up to kHighwayHashBatchLanes messages in lockstep so the multiply
+   and shuffle latencies of one message hide behind the others. */
+static inline void InternalProcessBatch(InternalState *restrict states,
+                                        const InternalState *restrict init,
+                                        const uint8_t *const *data,
+                                        const size_t *sizes, size_t num) {
+  size_t max_packets = 0;
+  for (size_t j = 0; j < num; j++) {
+    states[j] = *init;
+    if (sizes[j] / 32 > max_packets) {
+      max_packets = sizes[j] / 32;
+    }
+  }
+  for (size_t p = 0; p < max_packets; p++) {
+    for (size_t j = 0; j < num; j++) {
+      if (p < sizes[j] / 32) {
+        InternalHighwayHashUpdatePacket(&states[j], data[j] + p * 32);
+      }
+    }
+  }
+  for (size_t j = 0; j < num; j++) {
+    if ((sizes[j] & 31) != 0) {
+      InternalHighwayHashUpdateRemainder(
+          &states[j], data[j] + (sizes[j] & ~(size_t)31), sizes[j] & 31);
+    }
+  }
+}
+
+static inline void InternalPermuteAndUpdateBatch(InternalState *restrict states,
+                                                 size_t num, int rounds) {
+  for (int r = 0; r < rounds; r++) {
+    for (size_t j = 0; j < num; j++) {
+      InternalPermuteAndUpdate(&states[j]);
+    }
+  }
+}
+
 /*////////////////////////////////////////////////////////////////////////////*/
-/* Low-level API, use for implementing streams etc...                         */
+/* Backend entry points                                                       */
 /*////////////////////////////////////////////////////////////////////////////*/
 
-/* Initializes state with given key */
-void HighwayHashReset(HighwayHashState *restrict state,
+static void Avx2Reset(HighwayHashState *restrict state,
                       const uint64_t *restrict key) {
-  __m256i temp = _mm256_loadu_si256((const __m256i_u *restrict)key);
-  InternalHighwayHashReset(state, &temp);
+  InternalState internal;
+  __m256i temp = _mm256_loadu_si256((const __m256i_u *)key);
+  InternalHighwayHashReset(&internal, &temp);
+  InternalStoreState(state, &internal);
 }
 
-/* Takes a packet of 32 bytes */
-void HighwayHashUpdatePacket(HighwayHashState *restrict state,
-                             const uint8_t *restrict packet) {
-  __m256i temp = _mm256_loadu_si256((const __m256i *restrict)packet);
-  InternalHighwayHashUpdatePacket(state, &temp);
+static void Avx2UpdatePackets(HighwayHashState *restrict state,
+                              const uint8_t *restrict packets,
+                              size_t num_packets) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  for (size_t i = 0; i < num_packets; i++) {
+    InternalHighwayHashUpdatePacket(&internal, packets + i * 32);
+  }
+  InternalStoreState(state, &internal);
 }
 
-/* Adds the final 1..31 bytes, do not use if 0 remain */
-void HighwayHashUpdateRemainder(HighwayHashState *restrict state,
+static void Avx2UpdateRemainder(HighwayHashState *restrict state,
                                 const uint8_t *restrict bytes,
                                 size_t size_mod32) {
-  __m256i temp = _mm256_loadu_si256((const __m256i *restrict)bytes);
-  InternalHighwayHashUpdateRemainder(state, &temp, (int)size_mod32);
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  InternalHighwayHashUpdateRemainder(&internal, bytes, size_mod32);
+  InternalStoreState(state, &internal);
 }
 
-/* Compute final 64-bit hash value. Makes state invalid. */
-uint64_t HighwayHashFinalize64(HighwayHashState *restrict state) {
-  return InternalHighwayHashFinalize64(state);
+static uint64_t Avx2Finalize64(HighwayHashState *restrict state) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  return InternalHighwayHashFinalize64(&internal);
 }
 
-/* Compute final 128-bit hash value. Makes state invalid. */
-void HighwayHashFinalize128(HighwayHashState *restrict state,
+static void Avx2Finalize128(HighwayHashState *restrict state,
                             uint64_t *restrict hash) {
-  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(state));
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  _mm_storeu_si128((__m128i_u *)hash,
+                   InternalHighwayHashFinalize128(&internal));
 }
 
-/* Compute final 256-bit hash value. Makes state invalid. */
-void HighwayHashFinalize256(HighwayHashState *restrict state,
+static void Avx2Finalize256(HighwayHashState *restrict state,
                             uint64_t *restrict hash) {
-  _mm256_storeu_si256((__m256i_u *)hash, InternalHighwayHashFinalize256(state));
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  _mm256_storeu_si256((__m256i_u *)hash,
+                      InternalHighwayHashFinalize256(&internal));
+}
+
+static uint64_t Avx2Hash64(const uint8_t *restrict data, size_t size,
+                           const uint64_t *restrict key) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Avx2Hash128(const uint8_t *restrict data, size_t size,
+                        const uint64_t *restrict key, uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Avx2Hash256(const uint8_t *restrict data, size_t size,
+                        const uint64_t *restrict key, uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  _mm256_storeu_si256((__m256i_u *)hash,
+                      InternalHighwayHashFinalize256(&state));
+}
+
+static uint64_t Avx2Hash64Keyed(const HighwayHashState *restrict start,
+                                const uint8_t *restrict data, size_t size) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Avx2Hash128Keyed(const HighwayHashState *restrict start,
+                             const uint8_t *restrict data, size_t size,
+                             uint64_t *restrict hash) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Avx2Hash256Keyed(const HighwayHashState *restrict start,
+                             const uint8_t *restrict data, size_t size,
+                             uint64_t *restrict hash) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  _mm256_storeu_si256((__m256i_u *)hash,
+                      InternalHighwayHashFinalize256(&state));
+}
+
+static uint64_t Avx2Hash64Packet(uint64_t lane0, uint64_t lane1,
+                                 uint64_t lane2, uint64_t lane3,
+                                 size_t size_mod32,
+                                 const uint64_t *restrict key) {
+  InternalState state;
+  InternalProcessLanes(&state,
+                       _mm256_setr_epi64x((long long)lane0, (long long)lane1,
+                                          (long long)lane2, (long long)lane3),
+                       size_mod32, key);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Avx2Hash128Packet(uint64_t lane0, uint64_t lane1,
+                              uint64_t lane2, uint64_t lane3,
+                              size_t size_mod32,
+                              const uint64_t *restrict key,
+                              uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessLanes(&state,
+                       _mm256_setr_epi64x((long long)lane0, (long long)lane1,
+                                          (long long)lane2, (long long)lane3),
+                       size_mod32, key);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Avx2Hash64Batch(const HighwayHashState *restrict start,
+                            const uint8_t *const *data, const size_t *sizes,
+                            size_t count, uint64_t *restrict hashes) {
+  InternalState init;
+  InternalState states[kHighwayHashBatchLanes];
+  InternalLoadState(&init, start);
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    InternalProcessBatch(states, &init, data + i, sizes + i, num);
+    InternalPermuteAndUpdateBatch(states, num, 4);
+    for (size_t j = 0; j < num; j++) {
+      const __m256i sum = _mm256_add_epi64(
+          _mm256_add_epi64(states[j].v0, states[j].v1),
+          _mm256_add_epi64(states[j].mul0, states[j].mul1));
+      hashes[i + j] = (uint64_t)_mm256_extract_epi64(sum, 0);
+    }
+  }
 }
+
+static void Avx2Hash128Batch(const HighwayHashState *restrict start,
+                             const uint8_t *const *data, const size_t *sizes,
+                             size_t count, uint64_t *restrict hashes) {
+  InternalState init;
+  InternalState states[kHighwayHashBatchLanes];
+  InternalLoadState(&init, start);
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    InternalProcessBatch(states, &init, data + i, sizes + i, num);
+    InternalPermuteAndUpdateBatch(states, num, 6);
+    for (size_t j = 0; j < num; j++) {
+      const __m256i sum0 = _mm256_add_epi64(states[j].v0, states[j].mul0);
+      __m256i sum1 = _mm256_add_epi64(states[j].v1, states[j].mul1);
+      sum1 = _mm256_permute2x128_si256(sum1, sum1, 0x01);
+      _mm_storeu_si128((__m128i_u *)(hashes + 2 * (i + j)),
+                       _mm256_castsi256_si128(_mm256_add_epi64(sum0, sum1)));
+    }
+  }
+}
+
+/* Hashes one message under k keys, kHighwayHashBatchLanes at a time in
+   lockstep, loading each packet once per group. The message is read again
+   for every group. */
+static void Avx2Hash64MultiKey(const uint8_t *restrict data, size_t size,
+                               const uint64_t *restrict keys, size_t k,
+                               uint64_t *restrict hashes) {
+  InternalState states[kHighwayHashBatchLanes];
+  for (size_t i = 0; i < k; i += kHighwayHashBatchLanes) {
+    const size_t num =
+        k - i < kHighwayHashBatchLanes ? k - i : kHighwayHashBatchLanes;
+    for (size_t j = 0; j < num; j++) {
+      const __m256i key =
+          _mm256_loadu_si256((const __m256i_u *)(keys + 4 * (i + j)));
+      InternalHighwayHashReset(&states[j], &key);
+    }
+    for (size_t p = 0; p + 32 <= size; p += 32) {
+      const __m256i packet = _mm256_loadu_si256((const __m256i_u *)(data + p));
+      for (size_t j = 0; j < num; j++) {
+        InternalUpdate(&states[j], &packet);
+      }
+    }
+    if ((size & 31) != 0) {
+      const __m256i packet =
+          InternalRemainderPacket(data + (size & ~(size_t)31), size & 31);
+      for (size_t j = 0; j < num; j++) {
+        InternalInjectSize(&states[j], size & 31);
+        InternalUpdate(&states[j], &packet);
+      }
+    }
+    InternalPermuteAndUpdateBatch(states, num, 4);
+    for (size_t j = 0; j < num; j++) {
+      const __m256i sum = _mm256_add_epi64(
+          _mm256_add_epi64(states[j].v0, states[j].v1),
+          _mm256_add_epi64(states[j].mul0, states[j].mul1));
+      hashes[i + j] = (uint64_t)_mm256_extract_epi64(sum, 0);
+    }
+  }
+}
+
+const HighwayHashBackendOps kHighwayHashAvx2Ops = {
+    .reset = Avx2Reset,
+    .update_packets = Avx2UpdatePackets,
+    .update_remainder = Avx2UpdateRemainder,
+    .finalize64 = Avx2Finalize64,
+    .finalize128 = Avx2Finalize128,
+    .finalize256 = Avx2Finalize256,
+    .hash64 = Avx2Hash64,
+    .hash128 = Avx2Hash128,
+    .hash256 = Avx2Hash256,
+    .hash64_keyed = Avx2Hash64Keyed,
+    .hash128_keyed = Avx2Hash128Keyed,
+    .hash256_keyed = Avx2Hash256Keyed,
+    .hash64_packet = Avx2Hash64Packet,
+    .hash128_packet = Avx2Hash128Packet,
+    .hash64_batch = Avx2Hash64Batch,
+    .hash128_batch = Avx2Hash128Batch,
+    .hash64_multikey = Avx2Hash64MultiKey,
+};
@@ -0,0 +1,641 @@
+#include "highwayhash_backend.h"
+
+#include <immintrin.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Single messages use one ymm register per state vector like the AVX2
+   backend, but with AVX-512VL rotates, masked loads and ternary logic.
+   The batch entry points pack two states into each zmm register and run
+   them in lockstep, masking off a message once it has no packets left. */
+typedef struct {
+  __m256i v0;
+  __m256i v1;
+  __m256i mul0;
+  __m256i mul1;
+} InternalState;
+
+/* Two states, the first in the low and the second in the high 256 bits */
+typedef struct {
+  __m512i v0;
+  __m512i v1;
+  __m512i mul0;
+  __m512i mul1;
+} InternalState2;
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation, one message                                       */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static inline void InternalLoadState(InternalState *restrict state,
+                                     const HighwayHashState *restrict src) {
+  state->v0 = _mm256_loadu_si256((const __m256i_u *)src->v0);
+  state->v1 = _mm256_loadu_si256((const __m256i_u *)src->v1);
+  state->mul0 = _mm256_loadu_si256((const __m256i_u *)src->mul0);
+  state->mul1 = _mm256_loadu_si256((const __m256i_u *)src->mul1);
+}
+
+static inline void InternalStoreState(HighwayHashState *restrict dst,
+                                      const InternalState *restrict state) {
+  _mm256_storeu_si256((__m256i_u *)dst->v0, state->v0);
+  _mm256_storeu_si256((__m256i_u *)dst->v1, state->v1);
+  _mm256_storeu_si256((__m256i_u *)dst->mul0, state->mul0);
+  _mm256_storeu_si256((__m256i_u *)dst->mul1, state->mul1);
+}
+
+static inline void InternalHighwayHashReset(InternalState *restrict state,
+                                            const uint64_t *restrict key) {
+  const __m256i key256 = _mm256_loadu_si256((const __m256i_u *)key);
+  state->mul0 = _mm256_setr_epi64x(0xdbe6d5d5fe4cce2f, 0xa4093822299f31d0,
+                                   0x13198a2e03707344, 0x243f6a8885a308d3);
+  state->mul1 = _mm256_setr_epi64x(0x3bd39e10cb0ef593, 0xc0acf169b5f18a8c,
+                                   0xbe5466cf34e90c6c, 0x452821e638d01377);
+  state->v0 = _mm256_xor_si256(state->mul0, key256);
+  state->v1 = _mm256_xor_si256(state->mul1, _mm256_ror_epi64(key256, 32));
+}
+
+static inline __m256i InternalZipperMerge(const __m256i v) {
+  const long long hi = 0x070806090D0A040B;
+  const long long lo = 0x000F010E05020C03;
+  return _mm256_shuffle_epi8(v, _mm256_set_epi64x(hi, lo, hi, lo));
+}
+
+static inline void InternalUpdate(InternalState *restrict state,
+                                  const __m256i lanes) {
+  state->v1 = _mm256_add_epi64(state->v1, _mm256_add_epi64(state->mul0, lanes));
+  state->mul0 = _mm256_xor_si256(
+      state->mul0,
+      _mm256_mul_epu32(state->v1, _mm256_srli_epi64(state->v0, 32)));
+  state->v0 = _mm256_add_epi64(state->v0, state->mul1);
+  state->mul1 = _mm256_xor_si256(
+      state->mul1,
+      _mm256_mul_epu32(state->v0, _mm256_srli_epi64(state->v1, 32)));
+  state->v0 = _mm256_add_epi64(state->v0, InternalZipperMerge(state->v1));
+  state->v1 = _mm256_add_epi64(state->v1, InternalZipperMerge(state->v0));
+}
+
+static inline void
+InternalHighwayHashUpdatePacket(InternalState *restrict state,
+                                const uint8_t *restrict packet) {
+  InternalUpdate(state, _mm256_loadu_si256((const __m256i_u *)packet));
+}
+
+/* Builds the zero-padded remainder packet. The masked load never touches
+   bytes past the end of the input, so this is safe at a page boundary. */
+static inline __m256i InternalRemainderPacket(const uint8_t *restrict bytes,
+                                              const size_t size_mod32) {
+  const size_t size_mod4 = size_mod32 & 3;
+  const uint8_t *remainder = bytes + (size_mod32 & ~3);
+  __m256i packet = _mm256_maskz_loadu_epi8(
+      (__mmask32)((1u << (size_mod32 & ~3)) - 1), bytes);
+
+  if (size_mod32 & 16) { // size_mod32 >= 16
+    uint32_t last4;
+    memcpy(&last4, remainder + size_mod4 - 4, 4);
+    packet = _mm256_insert_epi32(packet, (int)last4, 7);
+  } else if (size_mod4) {
+    const uint32_t last3 = (uint32_t)remainder[0] |
+                           ((uint32_t)remainder[size_mod4 >> 1] << 8) |
+                           ((uint32_t)remainder[size_mod4 - 1] << 16);
+    packet = _mm256_insert_epi32(packet, (int)last3, 4);
+  }
+  return packet;
+}
+
+static inline void InternalInjectSize(InternalState *restrict state,
+                                      const size_t size_mod32) {
+  const __m256i size_mod32_256 = _mm256_set1_epi32((int)size_mod32);
+  state->v0 = _mm256_add_epi64(state->v0, size_mod32_256);
+  state->v1 = _mm256_rolv_epi32(state->v1, size_mod32_256);
+}
+
+static inline void
+InternalHighwayHashUpdateRemainder(InternalState *restrict state,
+                                   const uint8_t *restrict bytes,
+                                   const size_t size_mod32) {
+  InternalInjectSize(state, size_mod32);
+  InternalUpdate(state, InternalRemainderPacket(bytes, size_mod32));
+}
+
+static inline void InternalPermuteAndUpdate(InternalState *restrict state) {
+  // Swaps the 128-bit halves and the 32-bit halves of every lane.
+  InternalUpdate(state, _mm256_permutexvar_epi32(
+                            _mm256_setr_epi32(5, 4, 7, 6, 1, 0, 3, 2),
+                            state->v0));
+}
+
+static inline uint64_t
+InternalHighwayHashFinalize64(InternalState *restrict state) {
+  for (int i = 0; i < 4; i++) {
+    InternalPermuteAndUpdate(state);
+  }
+  const __m256i sum =
+      _mm256_add_epi64(_mm256_add_epi64(state->v0, state->v1),
+                       _mm256_add_epi64(state->mul0, state->mul1));
+  return (uint64_t)_mm_cvtsi128_si64(_mm256_castsi256_si128(sum));
+}
+
+static inline __m128i
+InternalHighwayHashFinalize128(InternalState *restrict state) {
+  for (int i = 0; i < 6; i++) {
+    InternalPermuteAndUpdate(state);
+  }
+  const __m256i sum0 = _mm256_add_epi64(state->v0, state->mul0);
+  const __m256i sum1 = _mm256_permute4x64_epi64(
+      _mm256_add_epi64(state->v1, state->mul1), _MM_SHUFFLE(1, 0, 3, 2));
+  return _mm256_castsi256_si128(_mm256_add_epi64(sum0, sum1));
+}
+
+// Each 128-bit half holds (a3, a2) in b32a32 and (a1, a0) in b10a10.
+static inline __m256i ModularReduction(const __m256i b32a32,
+                                       const __m256i b10a10) {
+  const __m256i mask = _mm256_setr_epi64x(-1, 0x3FFFFFFFFFFFFFFF, -1,
+                                          0x3FFFFFFFFFFFFFFF);
+  const __m256i x = _mm256_and_si256(b32a32, mask);
+
+  // 128-bit shifts: the bits shifted out of a2 are carried into a3.
+  const __m256i shifted1 = _mm256_or_si256(
+      _mm256_slli_epi64(x, 1), _mm256_slli_si256(_mm256_srli_epi64(x, 63), 8));
+  const __m256i shifted2 = _mm256_or_si256(
+      _mm256_slli_epi64(x, 2), _mm256_slli_si256(_mm256_srli_epi64(x, 62), 8));
+
+  // 0x96 is a three-way XOR.
+  return _mm256_ternarylogic_epi64(b10a10, shifted1, shifted2, 0x96);
+}
+
+static inline __m256i
+InternalHighwayHashFinalize256(InternalState *restrict state) {
+  for (int i = 0; i < 10; i++) {
+    InternalPermuteAndUpdate(state);
+  }
+  const __m256i sum0 = _mm256_add_epi64(state->v0, state->mul0);
+  const __m256i sum1 = _mm256_add_epi64(state->v1, state->mul1);
+  return ModularReduction(sum1, sum0);
+}
+
+static inline void InternalProcessData(InternalState *restrict state,
+                                       const uint8_t *restrict data,
+                                       size_t size) {
+  size_t i = 0;
+  while (i + 32 <= size) {
+    InternalHighwayHashUpdatePacket(state, data + i);
+    i += 32;
+  }
+  if ((size & 31) != 0) {
+    InternalHighwayHashUpdateRemainder(state, data + i, size & 31);
+  }
+}
+
+static inline void InternalProcessAll(InternalState *restrict state,
+                                      const uint8_t *restrict data,
+                                      size_t size,
+                                      const uint64_t *restrict key) {
+  InternalHighwayHashReset(state, key);
+  InternalProcessData(state, data, size);
+}
+
+static inline void InternalProcessLanes(InternalState *restrict state,
+                                        const __m256i lanes,
+                                        size_t size_mod32,
+                                        const uint64_t *restrict key) {
+  InternalHighwayHashReset(state, key);
+  if (size_mod32 != 0) {
+    InternalInjectSize(state, size_mod32);
+  }
+  InternalUpdate(state, lanes);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation, two messages in lockstep                          */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Masks selecting the 64-bit lanes of the first and second message */
+#define kFirst ((__mmask8)0x0F)
+#define kSecond ((__mmask8)0xF0)
+
+static inline __m512i Combine(const __m256i lo, const __m256i hi) {
+  return _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1);
+}
+
+static inline void InternalBroadcastState(InternalState2 *restrict state,
+                                          const InternalState *restrict src) {
+  state->v0 = _mm512_broadcast_i64x4(src->v0);
+  state->v1 = _mm512_broadcast_i64x4(src->v1);
+  state->mul0 = _mm512_broadcast_i64x4(src->mul0);
+  state->mul1 = _mm512_broadcast_i64x4(src->mul1);
+}
+
+static inline __m512i InternalZipperMerge2(const __m512i v) {
+  const long long hi = 0x070806090D0A040B;
+  const long long lo = 0x000F010E05020C03;
+  return _mm512_shuffle_epi8(
+      v, _mm512_set_epi64(hi, lo, hi, lo, hi, lo, hi, lo));
+}
+
+/* Updates only the messages selected by active, the other lanes keep their
+   previous values. */
+static inline void InternalUpdate2(InternalState2 *restrict state,
+                                   const __m512i lanes, const __mmask8 active) {
+  state->v1 = _mm512_mask_add_epi64(state->v1, active, state->v1,
+                                    _mm512_add_epi64(state->mul0, lanes));
+  state->mul0 = _mm512_mask_xor_epi64(
+      state->mul0, active, state->mul0,
+      _mm512_mul_epu32(state->v1, _mm512_srli_epi64(state->v0, 32)));
+  state->v0 = _mm512_mask_add_epi64(state->v0, active, state->v0, state->mul1);
+  state->mul1 = _mm512_mask_xor_epi64(
+      state->mul1, active, state->mul1,
+      _mm512_mul_epu32(state->v0, _mm512_srli_epi64(state->v1, 32)));
+  state->v0 = _mm512_mask_add_epi64(state->v0, active, state->v0,
+                                    InternalZipperMerge2(state->v1));
+  state->v1 = _mm512_mask_add_epi64(state->v1, active, state->v1,
+                                    InternalZipperMerge2(state->v0));
+}
+
+static inline void InternalPermuteAndUpdate2(InternalState2 *restrict state) {
+  const __m512i indices = _mm512_setr_epi32(5, 4, 7, 6, 1, 0, 3, 2, 13, 12, 15,
+                                            14, 9, 8, 11, 10);
+  InternalUpdate2(state, _mm512_permutexvar_epi32(indices, state->v0),
+                  kFirst | kSecond);
+}
+
+/* A message that ran out of packets gets a zero size and is masked off, so
+   neither the size injection nor the rotation changes it. */
+static inline void InternalUpdateRemainder2(InternalState2 *restrict state,
+                                            const uint8_t *bytes0,
+                                            size_t size_mod32_0,
+                                            const uint8_t *bytes1,
+                                            size_t size_mod32_1) {
+  const __mmask8 active =
+      (size_mod32_0 ? kFirst : 0) | (size_mod32_1 ? kSecond : 0);
+  const __m512i sizes = Combine(_mm256_set1_epi32((int)size_mod32_0),
+                                _mm256_set1_epi32((int)size_mod32_1));
+  state->v0 = _mm512_add_epi64(state->v0, sizes);
+  state->v1 = _mm512_rolv_epi32(state->v1, sizes);
+  InternalUpdate2(state,
+                  Combine(InternalRemainderPacket(bytes0, size_mod32_0),
+                          InternalRemainderPacket(bytes1, size_mod32_1)),
+                  active);
+}
+
+/* Absorbs two messages, a missing second message has size 0. */
+static inline void InternalProcessPair(InternalState2 *restrict state,
+                                       const InternalState2 *restrict init,
+                                       const uint8_t *data0, size_t size0,
+                                       const uint8_t *data1, size_t size1) {
+  const size_t packets0 = size0 / 32;
+  const size_t packets1 = size1 / 32;
+  const size_t common = packets0 < packets1 ? packets0 : packets1;
+  *state = *init;
+  size_t p = 0;
+  for (; p < common; p++) {
+    InternalUpdate2(
+        state,
+        Combine(_mm256_loadu_si256((const __m256i_u *)(data0 + p * 32)),
+                _mm256_loadu_si256((const __m256i_u *)(data1 + p * 32))),
+        kFirst | kSecond);
+  }
+  for (; p < packets0; p++) {
+    InternalUpdate2(state,
+                    _mm512_castsi256_si512(_mm256_loadu_si256(
+                        (const __m256i_u *)(data0 + p * 32))),
+                    kFirst);
+  }
+  for (; p < packets1; p++) {
+    InternalUpdate2(state,
+                    _mm512_broadcast_i64x4(_mm256_loadu_si256(
+                        (const __m256i_u *)(data1 + p * 32))),
+                    kSecond);
+  }
+  if (((size0 | size1) & 31) != 0) {
+    InternalUpdateRemainder2(state, data0 + packets0 * 32, size0 & 31,
+                             data1 + packets1 * 32, size1 & 31);
+  }
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Backend entry points                                                       */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static void Avx512Reset(HighwayHashState *restrict state,
+                        const uint64_t *restrict key) {
+  InternalState internal;
+  InternalHighwayHashReset(&internal, key);
+  InternalStoreState(state, &internal);
+}
+
+static void Avx512UpdatePackets(HighwayHashState *restrict state,
+                                const uint8_t *restrict packets,
+                                size_t num_packets) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  for (size_t i = 0; i < num_packets; i++) {
+    InternalHighwayHashUpdatePacket(&internal, packets + i * 32);
+  }
+  InternalStoreState(state, &internal);
+}
+
+static void Avx512UpdateRemainder(HighwayHashState *restrict state,
+                                  const uint8_t *restrict bytes,
+                                  size_t size_mod32) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  InternalHighwayHashUpdateRemainder(&internal, bytes, size_mod32);
+  InternalStoreState(state, &internal);
+}
+
+static uint64_t Avx512Finalize64(HighwayHashState *restrict state) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  return InternalHighwayHashFinalize64(&internal);
+}
+
+static void Avx512Finalize128(HighwayHashState *restrict state,
+                              uint64_t *restrict hash) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  _mm_storeu_si128((__m128i_u *)hash,
+                   InternalHighwayHashFinalize128(&internal));
+}
+
+static void Avx512Finalize256(HighwayHashState *restrict state,
+                              uint64_t *restrict hash) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  _mm256_storeu_si256((__m256i_u *)hash,
+                      InternalHighwayHashFinalize256(&internal));
+}
+
+static uint64_t Avx512Hash64(const uint8_t *restrict data, size_t size,
+                             const uint64_t *restrict key) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Avx512Hash128(const uint8_t *restrict data, size_t size,
+                          const uint64_t *restrict key,
+                          uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Avx512Hash256(const uint8_t *restrict data, size_t size,
+                          const uint64_t *restrict key,
+                          uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  _mm256_storeu_si256((__m256i_u *)hash,
+                      InternalHighwayHashFinalize256(&state));
+}
+
+static uint64_t Avx512Hash64Keyed(const HighwayHashState *restrict start,
+                                  const uint8_t *restrict data, size_t size) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Avx512Hash128Keyed(const HighwayHashState *restrict start,
+                               const uint8_t *restrict data, size_t size,
+                               uint64_t *restrict hash) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Avx512Hash256Keyed(const HighwayHashState *restrict start,
+                               const uint8_t *restrict data, size_t size,
+                               uint64_t *restrict hash) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  _mm256_storeu_si256((__m256i_u *)hash,
+                      InternalHighwayHashFinalize256(&state));
+}
+
+static uint64_t Avx512Hash64Packet(uint64_t lane0, uint64_t lane1,
+                                   uint64_t lane2, uint64_t lane3,
+                                   size_t size_mod32,
+                                   const uint64_t *restrict key) {
+  InternalState state;
+  InternalProcessLanes(&state,
+                       _mm256_setr_epi64x((long long)lane0, (long long)lane1,
+                                          (long long)lane2, (long long)lane3),
+                       size_mod32, key);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Avx512Hash128Packet(uint64_t lane0, uint64_t lane1,
+                                uint64_t lane2, uint64_t lane3,
+                                size_t size_mod32,
+                                const uint64_t *restrict key,
+                                uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessLanes(&state,
+                       _mm256_setr_epi64x((long long)lane0, (long long)lane1,
+                                          (long long)lane2, (long long)lane3),
+                       size_mod32, key);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+/* Runs kHighwayHashBatchLanes messages as two interleaved pairs and leaves
+   them ready for the final sums. Missing messages at the end of the input
+   are hashed as empty and their results dropped by the callers. */
+static inline void InternalProcessBatch(InternalState2 *restrict pairs,
+                                        const InternalState2 *restrict init,
+                                        const uint8_t *const *data,
+                                        const size_t *sizes, size_t num,
+                                        int rounds) {
+  static const uint8_t kEmpty[1] = {0};
+  const uint8_t *ptrs[kHighwayHashBatchLanes];
+  size_t lens[kHighwayHashBatchLanes];
+  for (size_t j = 0; j < kHighwayHashBatchLanes; j++) {
+    ptrs[j] = j < num ? data[j] : kEmpty;
+    lens[j] = j < num ? sizes[j] : 0;
+  }
+  InternalProcessPair(&pairs[0], init, ptrs[0], lens[0], ptrs[1], lens[1]);
+  InternalProcessPair(&pairs[1], init, ptrs[2], lens[2], ptrs[3], lens[3]);
+  for (int r = 0; r < rounds; r++) {
+    InternalPermuteAndUpdate2(&pairs[0]);
+    InternalPermuteAndUpdate2(&pairs[1]);
+  }
+}
+
+static void Avx512Hash64Batch(const HighwayHashState *restrict start,
+                              const uint8_t *const *data, const size_t *sizes,
+                              size_t count, uint64_t *restrict hashes) {
+  InternalState single;
+  InternalState2 init;
+  InternalState2 pairs[kHighwayHashBatchLanes / 2];
+  InternalLoadState(&single, start);
+  InternalBroadcastState(&init, &single);
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    InternalProcessBatch(pairs, &init, data + i, sizes + i, num, 4);
+    alignas(64) uint64_t sums[kHighwayHashBatchLanes / 2][8];
+    for (size_t k = 0; k < kHighwayHashBatchLanes / 2; k++) {
+      _mm512_store_si512(
+          sums[k], _mm512_add_epi64(_mm512_add_epi64(pairs[k].v0, pairs[k].v1),
+                                    _mm512_add_epi64(pairs[k].mul0,
+                                                     pairs[k].mul1)));
+    }
+    for (size_t j = 0; j < num; j++) {
+      hashes[i + j] = sums[j / 2][(j & 1) * 4];
+    }
+  }
+}
+
+static void Avx512Hash128Batch(const HighwayHashState *restrict start,
+                               const uint8_t *const *data, const size_t *sizes,
+                               size_t count, uint64_t *restrict hashes) {
+  InternalState single;
+  InternalState2 init;
+  InternalState2 pairs[kHighwayHashBatchLanes / 2];
+  InternalLoadState(&single, start);
+  InternalBroadcastState(&init, &single);
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    InternalProcessBatch(pairs, &init, data + i, sizes + i, num, 6);
+    alignas(64) uint64_t sums[kHighwayHashBatchLanes / 2][8];
+    for (size_t k = 0; k < kHighwayHashBatchLanes / 2; k++) {
+      const __m512i sum0 = _mm512_add_epi64(pairs[k].v0, pairs[k].mul0);
+      // vpermq swaps the 128-bit halves within each message.
+      const __m512i sum1 = _mm512_permutex_epi64(
+          _mm512_add_epi64(pairs[k].v1, pairs[k].mul1),
+          _MM_SHUFFLE(1, 0, 3, 2));
+      _mm512_store_si512(sums[k], _mm512_add_epi64(sum0, sum1));
+    }
+    for (size_t j = 0; j < num; j++) {
+      hashes[2 * (i + j) + 0] = sums[j / 2][(j & 1) * 4 + 0];
+      hashes[2 * (i + j) + 1] = sums[j / 2][(j & 1) * 4 + 1];
+    }
+  }
+}
+
+/* Key pairs in flight in the multi-key entry point. Unlike the batch entry
+   points this one has no per-message loads to wait for, so more states fit
+   before the 32 vector registers run out. */
+#define kMultiKeyPairs 4
+
+/* Resets a state for the keys at lo and hi in its two halves */
+static inline void InternalResetPair(InternalState2 *restrict state,
+                                     const uint64_t *restrict lo,
+                                     const uint64_t *restrict hi) {
+  const __m512i key = Combine(_mm256_loadu_si256((const __m256i_u *)lo),
+                              _mm256_loadu_si256((const __m256i_u *)hi));
+  state->mul0 = _mm512_broadcast_i64x4(
+      _mm256_setr_epi64x(0xdbe6d5d5fe4cce2f, 0xa4093822299f31d0,
+                         0x13198a2e03707344, 0x243f6a8885a308d3));
+  state->mul1 = _mm512_broadcast_i64x4(
+      _mm256_setr_epi64x(0x3bd39e10cb0ef593, 0xc0acf169b5f18a8c,
+                         0xbe5466cf34e90c6c, 0x452821e638d01377));
+  state->v0 = _mm512_xor_si512(state->mul0, key);
+  state->v1 = _mm512_xor_si512(state->mul1, _mm512_ror_epi64(key, 32));
+}
+
+/* Hashes one message under num keys, at most 2 * num_pairs, two keys per
+   512-bit state, so each packet is loaded once and broadcast to both
+   halves. A missing key at the end repeats the last one and is dropped.
+   Always inlined with a constant num_pairs, so only the needed states are
+   updated and they stay in registers. */
+static inline __attribute__((always_inline)) void
+InternalMultiKeyGroup(const uint8_t *restrict data, size_t size,
+                      const uint64_t *restrict keys, size_t num,
+                      uint64_t *restrict hashes, size_t num_pairs) {
+  InternalState2 pairs[kMultiKeyPairs];
+  for (size_t q = 0; q < num_pairs; q++) {
+    const size_t j1 = 2 * q + 1 < num ? 2 * q + 1 : num - 1;
+    InternalResetPair(&pairs[q], keys + 4 * (2 * q), keys + 4 * j1);
+  }
+  for (size_t p = 0; p + 32 <= size; p += 32) {
+    const __m512i packet = _mm512_broadcast_i64x4(
+        _mm256_loadu_si256((const __m256i_u *)(data + p)));
+    for (size_t q = 0; q < num_pairs; q++) {
+      InternalUpdate2(&pairs[q], packet, kFirst | kSecond);
+    }
+  }
+  if ((size & 31) != 0) {
+    const __m512i packet = _mm512_broadcast_i64x4(
+        InternalRemainderPacket(data + (size & ~(size_t)31), size & 31));
+    const __m512i sizes = _mm512_set1_epi32((int)(size & 31));
+    for (size_t q = 0; q < num_pairs; q++) {
+      pairs[q].v0 = _mm512_add_epi64(pairs[q].v0, sizes);
+      pairs[q].v1 = _mm512_rolv_epi32(pairs[q].v1, sizes);
+      InternalUpdate2(&pairs[q], packet, kFirst | kSecond);
+    }
+  }
+  for (int r = 0; r < 4; r++) {
+    for (size_t q = 0; q < num_pairs; q++) {
+      InternalPermuteAndUpdate2(&pairs[q]);
+    }
+  }
+  for (size_t q = 0; q < num_pairs; q++) {
+    alignas(64) uint64_t sums[8];
+    _mm512_store_si512(
+        sums, _mm512_add_epi64(_mm512_add_epi64(pairs[q].v0, pairs[q].v1),
+                               _mm512_add_epi64(pairs[q].mul0, pairs[q].mul1)));
+    hashes[2 * q] = sums[0];
+    if (2 * q + 1 < num) {
+      hashes[2 * q + 1] = sums[4];
+    }
+  }
+}
+
+/* Runs groups of 2 * kMultiKeyPairs keys, reading the message again for
+   every group. A single key left over takes the one-key path, which does
+   half the work of a pair. */
+static void Avx512Hash64MultiKey(const uint8_t *restrict data, size_t size,
+                                 const uint64_t *restrict keys, size_t k,
+                                 uint64_t *restrict hashes) {
+  for (size_t i = 0; i < k; i += 2 * kMultiKeyPairs) {
+    const size_t num = k - i < 2 * kMultiKeyPairs ? k - i : 2 * kMultiKeyPairs;
+    const uint64_t *group_keys = keys + 4 * i;
+    switch ((num + 1) / 2) {
+    case 1:
+      if (num == 1) {
+        hashes[i] = Avx512Hash64(data, size, group_keys);
+      } else {
+        InternalMultiKeyGroup(data, size, group_keys, num, hashes + i, 1);
+      }
+      break;
+    case 2:
+      InternalMultiKeyGroup(data, size, group_keys, num, hashes + i, 2);
+      break;
+    case 3:
+      InternalMultiKeyGroup(data, size, group_keys, num, hashes + i, 3);
+      break;
+    default:
+      InternalMultiKeyGroup(data, size, group_keys, num, hashes + i, 4);
+      break;
+    }
+  }
+}
+
+const HighwayHashBackendOps kHighwayHashAvx512Ops = {
+    .reset = Avx512Reset,
+    .update_packets = Avx512UpdatePackets,
+    .update_remainder = Avx512UpdateRemainder,
+    .finalize64 = Avx512Finalize64,
+    .finalize128 = Avx512Finalize128,
+    .finalize256 = Avx512Finalize256,
+    .hash64 = Avx512Hash64,
+    .hash128 = Avx512Hash128,
+    .hash256 = Avx512Hash256,
+    .hash64_keyed = Avx512Hash64Keyed,
+    .hash128_keyed = Avx512Hash128Keyed,
+    .hash256_keyed = Avx512Hash256Keyed,
+    .hash64_packet = Avx512Hash64Packet,
+    .hash128_packet = Avx512Hash128Packet,
+    .hash64_batch = Avx512Hash64Batch,
+    .hash128_batch = Avx512Hash128Batch,
+    .hash64_multikey = Avx512Hash64MultiKey,
+};
@@ -0,0 +1,80 @@
+#ifndef C_HIGHWAYHASH_BACKEND_H_
+#define C_HIGHWAYHASH_BACKEND_H_
+
+#include "hh_c/highwayhash.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Backend interface, private to the library                                  */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Every backend fills one of these. The public API in highwayhash_common.c
+   forwards through the table picked at load time, so the hot loops live
+   inside the backends and cost one indirect call per message, not per
+   packet. */
+typedef struct {
+  void (*reset)(HighwayHashState *state, const uint64_t *key);
+  /* Takes num_packets consecutive packets of 32 bytes */
+  void (*update_packets)(HighwayHashState *state, const uint8_t *packets,
+                         size_t num_packets);
+  void (*update_remainder)(HighwayHashState *state, const uint8_t *bytes,
+                           size_t size_mod32);
+  uint64_t (*finalize64)(HighwayHashState *state);
+  void (*finalize128)(HighwayHashState *state, uint64_t *hash);
+  void (*finalize256)(HighwayHashState *state, uint64_t *hash);
+
+  uint64_t (*hash64)(const uint8_t *data, size_t size, const uint64_t *key);
+  void (*hash128)(const uint8_t *data, size_t size, const uint64_t *key,
+                  uint64_t *hash);
+  void (*hash256)(const uint8_t *data, size_t size, const uint64_t *key,
+                  uint64_t *hash);
+
+  /* Same as hash64 etc., starting from an already reset state */
+  uint64_t (*hash64_keyed)(const HighwayHashState *start, const uint8_t *data,
+                           size_t size);
+  void (*hash128_keyed)(const HighwayHashState *start, const uint8_t *data,
+                        size_t size, uint64_t *hash);
+  void (*hash256_keyed)(const HighwayHashState *start, const uint8_t *data,
+                        size_t size, uint64_t *hash);
+
+  /* Hashes a single packet whose lanes the caller already laid out. A
+     nonzero size_mod32 marks it as the remainder of a size_mod32 byte
+     message, zero as one full 32-byte message. The lanes are passed by
+     value, going through memory would cost a store forwarding stall. */
+  uint64_t (*hash64_packet)(uint64_t lane0, uint64_t lane1, uint64_t lane2,
+                            uint64_t lane3, size_t size_mod32,
+                            const uint64_t *key);
+  void (*hash128_packet)(uint64_t lane0, uint64_t lane1, uint64_t lane2,
+                         uint64_t lane3, size_t size_mod32,
+                         const uint64_t *key, uint64_t *hash);
+
+  /* count messages, each starting from the same already reset state */
+  void (*hash64_batch)(const HighwayHashState *start,
+                       const uint8_t *const *data, const size_t *sizes,
+                       size_t count, uint64_t *hashes);
+  void (*hash128_batch)(const HighwayHashState *start,
+                        const uint8_t *const *data, const size_t *sizes,
+                        size_t count, uint64_t *hashes);
+
+  /* One message under k keys, keys holds 4 words per key */
+  void (*hash64_multikey)(const uint8_t *data, size_t size,
+                          const uint64_t *keys, size_t k, uint64_t *hashes);
+} HighwayHashBackendOps;
+
+/* Number of messages a backend keeps in flight in the batch entry points */
+#define kHighwayHashBatchLanes 4
+
+extern const HighwayHashBackendOps kHighwayHashPortableOps;
+#ifdef HIGHWAYHASH_HAVE_SSE41
+extern const HighwayHashBackendOps kHighwayHashSse41Ops;
+#endif
+#ifdef HIGHWAYHASH_HAVE_AVX2
+extern const HighwayHashBackendOps kHighwayHashAvx2Ops;
+#endif
+#ifdef HIGHWAYHASH_HAVE_AVX512
+extern const HighwayHashBackendOps kHighwayHashAvx512Ops;
+#endif
+
+#endif // C_HIGHWAYHASH_BACKEND_H_
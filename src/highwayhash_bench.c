@@ -0,0 +1,271 @@
+#define _POSIX_C_SOURCE 199309L
+#include "hh_c/highwayhash.h"
+#include "hh_c/highwayhash_inline.h"
+#include "highwayhash_bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+/* Sweeps every available backend over the sizes below and prints one record
+   per (backend, function, size) as CSV or JSON lines:
+
+     hh_c_bench [--json] [--backend NAME] [--max-size BYTES] [--min-ms MS]
+
+   The inline definitions do not dispatch, so they are measured once, as
+   backend "inline". Each measurement repeats the call until at least min-ms
+   have passed and keeps the fastest of kRepetitions runs. Cycles are TSC
+   reference cycles, which are only comparable between runs on the same
+   machine. */
+
+#define kMaxSize (16u << 20)
+#define kRepetitions 3
+#define kCatFragment 1000
+
+static const uint64_t kKey[4] = {0x0706050403020100, 0x0F0E0D0C0B0A0908,
+                                 0x1716151413121110, 0x1F1E1D1C1B1A1918};
+
+static const size_t kSmallSizes[] = {0,  1,  3,  4,  7,  8,
+                                     15, 16, 31, 32, 63, 64};
+
+typedef enum {
+  kHash64,
+  kHash128,
+  kHash256,
+  kCat64,
+  kFixed64,
+  kKeyed64,
+  kInline64,
+  kNumFunctions
+} Function;
+
+static const char *const kFunctionNames[kNumFunctions] = {
+    "HighwayHash64", "HighwayHash128", "HighwayHash256", "HighwayHashCat64",
+    "HighwayHash64_fixed", "HighwayHash64WithKey",
+    "HighwayHashInline64WithKey_const"};
+
+static HighwayHashKey hkey;
+
+static volatile uint64_t sink;
+
+static uint64_t Cycles(void) {
+#if HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* Sizes spelled as constants, the way callers of the inline API hash
+   fixed-size keys, so the compiler can specialize each call. */
+static uint64_t InlineConstantSize(const uint8_t *data, size_t size) {
+  switch (size) {
+  case 4:
+    return HighwayHashInline64WithKey(data, 4, &hkey);
+  case 8:
+    return HighwayHashInline64WithKey(data, 8, &hkey);
+  case 16:
+    return HighwayHashInline64WithKey(data, 16, &hkey);
+  default:
+    return HighwayHashInline64WithKey(data, 32, &hkey);
+  }
+}
+
+/* The sizes the fixed-size and inline functions are measured at */
+static int IsFixedSize(size_t size) {
+  return size == 4 || size == 8 || size == 16 || size == 32;
+}
+
+static uint64_t RunOnce(Function function, const uint8_t *data, size_t size) {
+  uint64_t hash[4] = {0};
+  switch (function) {
+  case kHash64:
+    hash[0] = HighwayHash64(data, size, kKey);
+    break;
+  case kHash128:
+    HighwayHash128(data, size, kKey, hash);
+    break;
+  case kHash256:
+    HighwayHash256(data, size, kKey, hash);
+    break;
+  case kCat64: {
+    HighwayHashCat cat;
+    HighwayHashCatStart(&cat, kKey);
+    for (size_t i = 0; i < size; i += kCatFragment) {
+      const size_t num = size - i < kCatFragment ? size - i : kCatFragment;
+      HighwayHashCatAppend(&cat, data + i, num);
+    }
+    hash[0] = HighwayHashCatFinish64(&cat);
+    break;
+  }
+  case kFixed64:
+    if (size == 4) {
+      uint32_t value;
+      memcpy(&value, data, sizeof(value));
+      hash[0] = HighwayHash64_U32(value, kKey);
+    } else if (size == 8) {
+      uint64_t value;
+      memcpy(&value, data, sizeof(value));
+      hash[0] = HighwayHash64_U64(value, kKey);
+    } else if (size == 16) {
+      hash[0] = HighwayHash64_16B(data, kKey);
+    } else {
+      hash[0] = HighwayHash64_32B(data, kKey);
+    }
+    break;
+  case kKeyed64:
+    hash[0] = HighwayHash64WithKey(data, size, &hkey);
+    break;
+  case kInline64:
+    hash[0] = InlineConstantSize(data, size);
+    break;
+  default:
+    break;
+  }
+  return hash[0] ^ hash[1] ^ hash[2] ^ hash[3];
+}
+
+typedef struct {
+  uint64_t iterations;
+  double ns_per_call;
+  double cycles_per_call;
+} Measurement;
+
+static Measurement Measure(Function function, const uint8_t *data, size_t size,
+                           double min_ns) {
+  Measurement best = {0, 0.0, 0.0};
+  uint64_t iterations = 1;
+  // Grow the iteration count until a run lasts long enough to time.
+  for (;;) {
+    const double start = NowNs();
+    for (uint64_t i = 0; i < iterations; i++) {
+      sink += RunOnce(function, data, size);
+    }
+    if (NowNs() - start >= min_ns || iterations >= (1ull << 40)) {
+      break;
+    }
+    iterations *= 2;
+  }
+  for (int r = 0; r < kRepetitions; r++) {
+    const double start = NowNs();
+    const uint64_t start_cycles = Cycles();
+    for (uint64_t i = 0; i < iterations; i++) {
+      sink += RunOnce(function, data, size);
+    }
+    const uint64_t cycles = Cycles() - start_cycles;
+    const double ns_per_call = (NowNs() - start) / (double)iterations;
+    KeepFastest(&best.ns_per_call, &ns_per_call, 1, r);
+    // The cycles are those of the run whose time was kept.
+    if (best.ns_per_call == ns_per_call) {
+      best.cycles_per_call = (double)cycles / (double)iterations;
+    }
+  }
+  best.iterations = iterations;
+  return best;
+}
+
+static void Print(int json, const char *backend, Function function,
+                  size_t size, const Measurement *m) {
+  const int have_cycles_per_byte = HAVE_TSC && size > 0;
+  const BenchField fields[] = {
+      {"backend", backend, 0.0, 0},
+      {"function", kFunctionNames[function], 0.0, 0},
+      {"size", NULL, (double)size, 0},
+      {"iterations", NULL, (double)m->iterations, 0},
+      {"ns_per_call", NULL, m->ns_per_call, 3},
+      {"cycles_per_call", NULL, m->cycles_per_call, 1},
+      {"cycles_per_byte", NULL,
+       have_cycles_per_byte ? m->cycles_per_call / (double)size : 0.0,
+       have_cycles_per_byte ? 4 : -1},
+      {"gb_per_s", NULL, (double)size / m->ns_per_call, 4}};
+  PrintRecord(json, fields, sizeof(fields) / sizeof(fields[0]));
+}
+
+int main(int argc, char **argv) {
+  int json = 0;
+  const char *only_backend = NULL;
+  size_t max_size = kMaxSize;
+  double min_ms = 20.0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0) {
+      json = 1;
+    } else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+      only_backend = argv[++i];
+    } else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+      max_size = (size_t)strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) {
+      min_ms = strtod(argv[++i], NULL);
+    } else {
+      Usage(argv[0],
+            "[--json] [--backend NAME] [--max-size BYTES] [--min-ms MS]");
+    }
+  }
+  if (max_size > kMaxSize) {
+    max_size = kMaxSize;
+  }
+
+  HighwayHashKeyInit(&hkey, kKey);
+  uint8_t *data = AllocOrExit(kMaxSize);
+  for (size_t i = 0; i < kMaxSize; i++) {
+    data[i] = (uint8_t)(i * 131 + (i >> 8));
+  }
+
+  size_t sizes[sizeof(kSmallSizes) / sizeof(kSmallSizes[0]) + 32];
+  size_t num_sizes = 0;
+  for (size_t i = 0; i < sizeof(kSmallSizes) / sizeof(kSmallSizes[0]); i++) {
+    if (kSmallSizes[i] <= max_size) {
+      sizes[num_sizes++] = kSmallSizes[i];
+    }
+  }
+  for (size_t size = 128; size <= max_size; size *= 2) {
+    sizes[num_sizes++] = size;
+  }
+
+  const HighwayHashBackend best = HighwayHashGetBackend();
+  int matched = 0;
+  for (int b = 0; b < HIGHWAYHASH_BACKEND_COUNT; b++) {
+    const HighwayHashBackend backend = (HighwayHashBackend)b;
+    const char *name = HighwayHashBackendName(backend);
+    if (only_backend != NULL && strcmp(only_backend, name) != 0) {
+      continue;
+    }
+    if (HighwayHashSetBackend(backend) != 0) {
+      continue;
+    }
+    matched = 1;
+    for (int f = 0; f < kNumFunctions; f++) {
+      for (size_t i = 0; i < num_sizes; i++) {
+        if (f == kInline64 || (f == kFixed64 && !IsFixedSize(sizes[i]))) {
+          continue;
+        }
+        const Measurement m =
+            Measure((Function)f, data, sizes[i], min_ms * 1e6);
+        Print(json, name, (Function)f, sizes[i], &m);
+      }
+    }
+  }
+  HighwayHashSetBackend(best);
+  if (only_backend == NULL || strcmp(only_backend, "inline") == 0) {
+    matched = 1;
+    for (size_t i = 0; i < num_sizes; i++) {
+      if (IsFixedSize(sizes[i])) {
+        const Measurement m = Measure(kInline64, data, sizes[i], min_ms * 1e6);
+        Print(json, "inline", kInline64, sizes[i], &m);
+      }
+    }
+  }
+  free(data);
+
+  if (!matched) {
+    fprintf(stderr, "no available backend matches\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+#ifndef C_HIGHWAYHASH_BENCH_UTIL_H_
+#define C_HIGHWAYHASH_BENCH_UTIL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Helpers shared by the benchmark and test executables                       */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Users define _POSIX_C_SOURCE 199309L before any include for NowNs. */
+
+static inline double NowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* Deterministic inputs from a seed */
+static inline uint64_t SplitMix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return z ^ (z >> 31);
+}
+
+static inline void RandomBytes(uint64_t *state, uint8_t *bytes, size_t size) {
+  for (size_t i = 0; i < size; i += 8) {
+    const uint64_t word = SplitMix64(state);
+    memcpy(bytes + i, &word, size - i < 8 ? size - i : 8);
+  }
+}
+
+/* options is the part of the usage line after the program name */
+static inline void Usage(const char *argv0, const char *options) {
+  fprintf(stderr, "usage: %s %s\n", argv0, options);
+  exit(2);
+}
+
+/* malloc that exits on failure, also for size 0 */
+static inline void *AllocOrExit(size_t size) {
+  void *p = malloc(size != 0 ? size : 1);
+  if (p == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+/* Keeps the fastest of several runs: best[i] becomes ns[i] on the first
+   repetition and the smaller of the two after that. */
+static inline void KeepFastest(double *best, const double *ns, size_t num,
+                               int repetition) {
+  for (size_t i = 0; i < num; i++) {
+    if (repetition == 0 || ns[i] < best[i]) {
+      best[i] = ns[i];
+    }
+  }
+}
+
+/* One column of a result record: text if it is not NULL, else number with
+   the given decimals. Negative decimals mark a missing value, an empty CSV
+   column or JSON null. */
+typedef struct {
+  const char *name;
+  const char *text;
+  double number;
+  int decimals;
+} BenchField;
+
+/* Prints one record as a CSV line, after a header line on the first call,
+   or as a JSON object on its own line */
+static inline void PrintRecord(int json, const BenchField *fields,
+                               size_t num) {
+  static int header_printed = 0;
+  if (!json && !header_printed) {
+    for (size_t i = 0; i < num; i++) {
+      printf("%s%s", i ? "," : "", fields[i].name);
+    }
+    printf("\n");
+    header_printed = 1;
+  }
+  printf("%s", json ? "{" : "");
+  for (size_t i = 0; i < num; i++) {
+    const BenchField *f = &fields[i];
+    if (json) {
+      printf("%s\"%s\": ", i ? ", " : "", f->name);
+    } else if (i) {
+      printf(",");
+    }
+    if (f->text != NULL) {
+      printf(json ? "\"%s\"" : "%s", f->text);
+    } else if (f->decimals < 0) {
+      printf("%s", json ? "null" : "");
+    } else {
+      printf("%.*f", f->decimals, f->number);
+    }
+  }
+  printf("%s\n", json ? "}" : "");
+  fflush(stdout);
+}
+
+#endif // C_HIGHWAYHASH_BENCH_UTIL_H_
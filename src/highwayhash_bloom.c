@@ -0,0 +1,250 @@
+#define _DEFAULT_SOURCE
+#include "hh_c/highwayhash_bloom.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The AVX2 block functions are built whenever a backend that implies AVX2
+   is, and picked at run time like the backends themselves. */
+#if defined(HIGHWAYHASH_HAVE_AVX2) || defined(HIGHWAYHASH_HAVE_AVX512)
+#define HIGHWAYHASH_BLOOM_AVX2
+#include <immintrin.h>
+#endif
+
+#define kBlockWords 8
+#define kBlockBits (kBlockWords * 64)
+
+/* Keys hashed per batch call in the bulk functions. While one chunk is
+   applied, the blocks of the next one are already being fetched. */
+#define kChunkKeys 32
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Maps the first hash word to a block without a division */
+static inline uint64_t *Block(const HighwayHashBloom *bloom, uint64_t hash) {
+#if defined(__SIZEOF_INT128__)
+  __extension__ typedef unsigned __int128 uint128_t;
+  const size_t index = (size_t)(((uint128_t)hash * bloom->num_blocks) >> 64);
+#else
+  const size_t index = (size_t)(((hash >> 32) * bloom->num_blocks) >> 32);
+#endif
+  return bloom->blocks + index * kBlockWords;
+}
+
+/* Straight-line loops over the eight words, which compilers vectorize for
+   the baseline the library is built for */
+static inline void BlockSet(uint64_t *block, uint64_t probe) {
+  for (int i = 0; i < kBlockWords; i++) {
+    block[i] |= (uint64_t)1 << ((probe >> (6 * i)) & 63);
+  }
+}
+
+static inline int BlockTest(const uint64_t *block, uint64_t probe) {
+  uint64_t missing = 0;
+  for (int i = 0; i < kBlockWords; i++) {
+    missing |= ~block[i] & ((uint64_t)1 << ((probe >> (6 * i)) & 63));
+  }
+  return missing == 0;
+}
+
+#if defined(HIGHWAYHASH_BLOOM_AVX2)
+/* The one-bit masks of words 0..3 and 4..7, from 6 bits of probe each */
+__attribute__((target("avx2"))) static inline void
+InternalProbeMasks(uint64_t probe, __m256i *lo, __m256i *hi) {
+  const __m256i bits = _mm256_set1_epi64x((long long)probe);
+  const __m256i ones = _mm256_set1_epi64x(1);
+  const __m256i six_bits = _mm256_set1_epi64x(63);
+  *lo = _mm256_sllv_epi64(
+      ones, _mm256_and_si256(
+                _mm256_srlv_epi64(bits, _mm256_setr_epi64x(0, 6, 12, 18)),
+                six_bits));
+  *hi = _mm256_sllv_epi64(
+      ones, _mm256_and_si256(
+                _mm256_srlv_epi64(bits, _mm256_setr_epi64x(24, 30, 36, 42)),
+                six_bits));
+}
+
+__attribute__((target("avx2"))) static void
+InternalSetBlocks(const HighwayHashBloom *bloom, const uint64_t *hashes,
+                  size_t num) {
+  for (size_t j = 0; j < num; j++) {
+    __m256i lo;
+    __m256i hi;
+    InternalProbeMasks(hashes[2 * j + 1], &lo, &hi);
+    __m256i *words = (__m256i *)Block(bloom, hashes[2 * j]);
+    _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), lo));
+    _mm256_store_si256(words + 1,
+                       _mm256_or_si256(_mm256_load_si256(words + 1), hi));
+  }
+}
+
+__attribute__((target("avx2"))) static void
+InternalTestBlocks(const HighwayHashBloom *bloom, const uint64_t *hashes,
+                   size_t num, uint8_t *results) {
+  for (size_t j = 0; j < num; j++) {
+    __m256i lo;
+    __m256i hi;
+    InternalProbeMasks(hashes[2 * j + 1], &lo, &hi);
+    const __m256i *words = (const __m256i *)Block(bloom, hashes[2 * j]);
+    // testc is 1 when every mask bit is also set in the block.
+    const int all_set = _mm256_testc_si256(_mm256_load_si256(words), lo) &
+                        _mm256_testc_si256(_mm256_load_si256(words + 1), hi);
+    results[j] = (uint8_t)all_set;
+  }
+}
+
+/* The AVX2 and AVX-512 hash backends are only selected on CPUs with AVX2,
+   so the block functions follow the hash backend, and tests that switch
+   backends cover both versions. */
+static int UseAvx2(void) {
+  const HighwayHashBackend backend = HighwayHashGetBackend();
+  return (backend == HIGHWAYHASH_BACKEND_AVX2 ||
+          backend == HIGHWAYHASH_BACKEND_AVX512) &&
+         __builtin_cpu_supports("avx2");
+}
+#endif
+
+/* Sets the bits of num keys, two hash words per key */
+static void SetBlocks(const HighwayHashBloom *bloom, const uint64_t *hashes,
+                      size_t num) {
+#if defined(HIGHWAYHASH_BLOOM_AVX2)
+  if (UseAvx2()) {
+    InternalSetBlocks(bloom, hashes, num);
+    return;
+  }
+#endif
+  for (size_t j = 0; j < num; j++) {
+    BlockSet(Block(bloom, hashes[2 * j]), hashes[2 * j + 1]);
+  }
+}
+
+/* results[j] is 1 if all bits of key j are set */
+static void TestBlocks(const HighwayHashBloom *bloom, const uint64_t *hashes,
+                       size_t num, uint8_t *results) {
+#if defined(HIGHWAYHASH_BLOOM_AVX2)
+  if (UseAvx2()) {
+    InternalTestBlocks(bloom, hashes, num, results);
+    return;
+  }
+#endif
+  for (size_t j = 0; j < num; j++) {
+    results[j] =
+        (uint8_t)BlockTest(Block(bloom, hashes[2 * j]), hashes[2 * j + 1]);
+  }
+}
+
+static inline size_t ChunkSize(size_t count, size_t chunk) {
+  const size_t first = chunk * kChunkKeys;
+  return count - first < kChunkKeys ? count - first : kChunkKeys;
+}
+
+/* Hashes num keys, two words per key, and starts fetching their blocks */
+static void HashChunk(const HighwayHashBloom *bloom, const uint8_t *const *data,
+                      const size_t *sizes, size_t num, int for_write,
+                      uint64_t *hashes) {
+  HighwayHash128BatchWithKey(data, sizes, num, &bloom->hkey, hashes);
+  for (size_t j = 0; j < num; j++) {
+    if (for_write) {
+      __builtin_prefetch(Block(bloom, hashes[2 * j]), 1);
+    } else {
+      __builtin_prefetch(Block(bloom, hashes[2 * j]), 0);
+    }
+  }
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Public API                                                                 */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+int HighwayHashBloomInit(HighwayHashBloom *bloom, const uint64_t *key,
+                         size_t num_keys, size_t bits_per_key) {
+  uint64_t random_key[4];
+  if (key == NULL) {
+    if (getentropy(random_key, sizeof(random_key)) != 0) {
+      return -1;
+    }
+    key = random_key;
+  }
+  if (bits_per_key != 0 && num_keys > SIZE_MAX / bits_per_key) {
+    return -1;
+  }
+  size_t num_blocks = (num_keys * bits_per_key + kBlockBits - 1) / kBlockBits;
+  if (num_blocks == 0) {
+    num_blocks = 1;
+  }
+  if (num_blocks > SIZE_MAX / (kBlockWords * sizeof(uint64_t))) {
+    return -1;
+  }
+  const size_t bytes = num_blocks * kBlockWords * sizeof(uint64_t);
+  uint64_t *blocks = aligned_alloc(64, bytes);
+  if (blocks == NULL) {
+    return -1;
+  }
+  memset(blocks, 0, bytes);
+  HighwayHashKeyInit(&bloom->hkey, key);
+  bloom->blocks = blocks;
+  bloom->num_blocks = num_blocks;
+  return 0;
+}
+
+void HighwayHashBloomFree(HighwayHashBloom *bloom) {
+  free(bloom->blocks);
+  bloom->blocks = NULL;
+  bloom->num_blocks = 0;
+}
+
+void HighwayHashBloomInsert(HighwayHashBloom *bloom, const uint8_t *data,
+                            size_t size) {
+  uint64_t hash[2];
+  HighwayHash128WithKey(data, size, &bloom->hkey, hash);
+  SetBlocks(bloom, hash, 1);
+}
+
+int HighwayHashBloomQuery(const HighwayHashBloom *bloom, const uint8_t *data,
+                          size_t size) {
+  uint64_t hash[2];
+  uint8_t result;
+  HighwayHash128WithKey(data, size, &bloom->hkey, hash);
+  TestBlocks(bloom, hash, 1, &result);
+  return result;
+}
+
+/* Chunk c is hashed and prefetched in iteration c and applied in iteration
+   c + 1, after hashing the next chunk has given its blocks time to arrive. */
+void HighwayHashBloomInsertBatch(HighwayHashBloom *bloom,
+                                 const uint8_t *const *data,
+                                 const size_t *sizes, size_t count) {
+  uint64_t hashes[2][2 * kChunkKeys];
+  const size_t chunks = (count + kChunkKeys - 1) / kChunkKeys;
+  for (size_t c = 0; c <= chunks; c++) {
+    if (c < chunks) {
+      HashChunk(bloom, data + c * kChunkKeys, sizes + c * kChunkKeys,
+                ChunkSize(count, c), 1, hashes[c & 1]);
+    }
+    if (c > 0) {
+      SetBlocks(bloom, hashes[(c - 1) & 1], ChunkSize(count, c - 1));
+    }
+  }
+}
+
+void HighwayHashBloomQueryBatch(const HighwayHashBloom *bloom,
+                                const uint8_t *const *data,
+                                const size_t *sizes, size_t count,
+                                uint8_t *results) {
+  uint64_t hashes[2][2 * kChunkKeys];
+  const size_t chunks = (count + kChunkKeys - 1) / kChunkKeys;
+  for (size_t c = 0; c <= chunks; c++) {
+    if (c < chunks) {
+      HashChunk(bloom, data + c * kChunkKeys, sizes + c * kChunkKeys,
+                ChunkSize(count, c), 0, hashes[c & 1]);
+    }
+    if (c > 0) {
+      TestBlocks(bloom, hashes[(c - 1) & 1], ChunkSize(count, c - 1),
+                 results + (c - 1) * kChunkKeys);
+    }
+  }
+}
@@ -0,0 +1,122 @@
+#include "hh_c/highwayhash_cdc.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Part of the boundary definition, changing it moves every boundary */
+static const uint64_t kGearDomain[4] = {0x6364632f635f6868, 0x0000726165672f,
+                                        0xd6e8feb86659fd93,
+                                        0xa0761d6478bd642f};
+
+/* Bytes scanned before they are hashed, small enough to stay in L1 */
+#define kScanBlock 4096
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static inline size_t Min(size_t a, size_t b) { return a < b ? a : b; }
+
+/* Returns the number of bytes consumed, up to and including a boundary */
+static size_t Scan(HighwayHashCdc *restrict cdc, const uint8_t *restrict data,
+                   size_t size, uint64_t mask, int *restrict cut) {
+  uint64_t hash = cdc->hash;
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash << 1) + cdc->gear[data[i]];
+    if ((hash & mask) == 0) {
+      cdc->hash = hash;
+      *cut = 1;
+      return i + 1;
+    }
+  }
+  cdc->hash = hash;
+  return size;
+}
+
+static void EmitChunk(HighwayHashCdc *cdc, HighwayHashChunkCallback callback,
+                      void *opaque) {
+  HighwayHashChunk chunk;
+  chunk.offset = cdc->offset;
+  chunk.length = cdc->size;
+  HighwayHashCatFinish128(&cdc->cat, chunk.hash);
+  callback(&chunk, opaque);
+
+  cdc->offset += cdc->size;
+  cdc->size = 0;
+  cdc->hash = 0;
+  HighwayHashCatStartWithKey(&cdc->cat, &cdc->hkey);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Content-defined chunking API                                               */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+int HighwayHashCdcInit(HighwayHashCdc *cdc, const uint64_t *key,
+                       const HighwayHashCdcOptions *options) {
+  static const HighwayHashCdcOptions kDefaults = {2048, 8192, 65536};
+  if (options == NULL) {
+    options = &kDefaults;
+  }
+  const size_t avg = options->avg_size;
+  if (avg < 64 || avg > ((size_t)1 << 30) || (avg & (avg - 1)) != 0 ||
+      options->min_size > avg || avg > options->max_size) {
+    return -1;
+  }
+  const int bits = __builtin_ctzll((unsigned long long)avg);
+
+  uint64_t gear_key[4];
+  for (int i = 0; i < 4; i++) {
+    gear_key[i] = key[i] ^ kGearDomain[i];
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    cdc->gear[i] = HighwayHash64_U32(i, gear_key);
+  }
+  HighwayHashKeyInit(&cdc->hkey, key);
+  HighwayHashCatStartWithKey(&cdc->cat, &cdc->hkey);
+  cdc->mask_small = ~(uint64_t)0 << (64 - (bits + 2));
+  cdc->mask_large = ~(uint64_t)0 << (64 - (bits - 2));
+  cdc->hash = 0;
+  cdc->offset = 0;
+  cdc->size = 0;
+  cdc->options = *options;
+  return 0;
+}
+
+void HighwayHashCdcUpdate(HighwayHashCdc *cdc, const uint8_t *data,
+                          size_t size, HighwayHashChunkCallback callback,
+                          void *opaque) {
+  const HighwayHashCdcOptions *options = &cdc->options;
+  while (size > 0) {
+    size_t num;
+    int cut = 0;
+    if (cdc->size < options->min_size) {
+      // No boundary is possible yet, so these bytes are only hashed.
+      num = Min(options->min_size - cdc->size, size);
+    } else {
+      const size_t limit =
+          Min(Min(size, kScanBlock), options->max_size - cdc->size);
+      num = 0;
+      if (cdc->size < options->avg_size) {
+        num = Scan(cdc, data, Min(limit, options->avg_size - cdc->size),
+                   cdc->mask_small, &cut);
+      }
+      if (!cut && num < limit) {
+        num += Scan(cdc, data + num, limit - num, cdc->mask_large, &cut);
+      }
+    }
+    HighwayHashCatAppend(&cdc->cat, data, num);
+    cdc->size += num;
+    data += num;
+    size -= num;
+    if (cut || cdc->size == options->max_size) {
+      EmitChunk(cdc, callback, opaque);
+    }
+  }
+}
+
+void HighwayHashCdcFinish(HighwayHashCdc *cdc,
+                          HighwayHashChunkCallback callback, void *opaque) {
+  if (cdc->size != 0) {
+    EmitChunk(cdc, callback, opaque);
+  }
+}
@@ -0,0 +1,118 @@
+#include "hh_c/highwayhash_column.h"
+
+#include <stdint.h>
+
+/* Rows handed to the batch API at once. Null rows are left out, so a chunk
+   with nulls is gathered into a dense batch and its hashes scattered back. */
+#define kChunkRows 64
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static inline int IsValid(const uint8_t *validity, size_t row) {
+  return validity == NULL || ((validity[row / 8] >> (row % 8)) & 1);
+}
+
+/* Hashes the num rows whose bytes and sizes are given, where row j of the
+   chunk is row first + j of the column. */
+static void HashChunk(const uint8_t *const *ptrs, const size_t *sizes,
+                      size_t num, size_t first, const uint8_t *validity,
+                      const HighwayHashKey *hkey, uint64_t *hashes) {
+  if (validity == NULL) {
+    HighwayHash64BatchWithKey(ptrs, sizes, num, hkey, hashes + first);
+    return;
+  }
+  const uint8_t *dense_ptrs[kChunkRows];
+  size_t dense_sizes[kChunkRows];
+  uint64_t dense_hashes[kChunkRows];
+  size_t dense = 0;
+  for (size_t j = 0; j < num; j++) {
+    if (IsValid(validity, first + j)) {
+      dense_ptrs[dense] = ptrs[j];
+      dense_sizes[dense] = sizes[j];
+      dense++;
+    }
+  }
+  HighwayHash64BatchWithKey(dense_ptrs, dense_sizes, dense, hkey,
+                            dense_hashes);
+  dense = 0;
+  for (size_t j = 0; j < num; j++) {
+    hashes[first + j] = IsValid(validity, first + j)
+                            ? dense_hashes[dense++]
+                            : HIGHWAYHASH_COLUMN_NULL_HASH;
+  }
+}
+
+/* fmix64 from MurmurHash3, a bijection that spreads every input bit over
+   the whole word. */
+static inline uint64_t Mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 33;
+  return h;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Public API                                                                 */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+void HighwayHashColumnBinary(const int32_t *offsets, const uint8_t *data,
+                             const uint8_t *validity, size_t count,
+                             const HighwayHashKey *hkey, uint64_t *hashes) {
+  const uint8_t *ptrs[kChunkRows];
+  size_t sizes[kChunkRows];
+  for (size_t i = 0; i < count; i += kChunkRows) {
+    const size_t num = count - i < kChunkRows ? count - i : kChunkRows;
+    for (size_t j = 0; j < num; j++) {
+      ptrs[j] = data + offsets[i + j];
+      sizes[j] = (size_t)(offsets[i + j + 1] - offsets[i + j]);
+    }
+    HashChunk(ptrs, sizes, num, i, validity, hkey, hashes);
+  }
+}
+
+void HighwayHashColumnLargeBinary(const int64_t *offsets, const uint8_t *data,
+                                  const uint8_t *validity, size_t count,
+                                  const HighwayHashKey *hkey,
+                                  uint64_t *hashes) {
+  const uint8_t *ptrs[kChunkRows];
+  size_t sizes[kChunkRows];
+  for (size_t i = 0; i < count; i += kChunkRows) {
+    const size_t num = count - i < kChunkRows ? count - i : kChunkRows;
+    for (size_t j = 0; j < num; j++) {
+      ptrs[j] = data + offsets[i + j];
+      sizes[j] = (size_t)(offsets[i + j + 1] - offsets[i + j]);
+    }
+    HashChunk(ptrs, sizes, num, i, validity, hkey, hashes);
+  }
+}
+
+void HighwayHashColumnFixed(const uint8_t *data, size_t width, size_t stride,
+                            const uint8_t *validity, size_t count,
+                            const HighwayHashKey *hkey, uint64_t *hashes) {
+  const uint8_t *ptrs[kChunkRows];
+  size_t sizes[kChunkRows];
+  for (size_t j = 0; j < kChunkRows; j++) {
+    sizes[j] = width;
+  }
+  for (size_t i = 0; i < count; i += kChunkRows) {
+    const size_t num = count - i < kChunkRows ? count - i : kChunkRows;
+    for (size_t j = 0; j < num; j++) {
+      ptrs[j] = data + (i + j) * stride;
+    }
+    HashChunk(ptrs, sizes, num, i, validity, hkey, hashes);
+  }
+}
+
+/* The row hash is mixed before the column hash goes in, which makes the
+   fold depend on the column order. The constant keeps a zero row hash from
+   mixing to zero. */
+void HighwayHashColumnCombine(uint64_t *row_hashes,
+                              const uint64_t *column_hashes, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    row_hashes[i] = Mix(row_hashes[i] + 0x9E3779B97F4A7C15) ^ column_hashes[i];
+  }
+}
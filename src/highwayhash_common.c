@@ -1,47 +1,297 @@
 #include "hh_c/highwayhash.h"
+#include "highwayhash_backend.h"
+#include "highwayhash_stats_internal.h"
 
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 
 /*////////////////////////////////////////////////////////////////////////////*/
-/* Non-cat API: single call on full data                                      */
+/* Backend selection                                                          */
 /*////////////////////////////////////////////////////////////////////////////*/
 
-void ProcessAll(HighwayHashState *restrict state, const uint8_t *restrict data,
-                size_t size, const uint64_t *restrict key) {
-  HighwayHashReset(state, key);
+static const char *const kBackendNames[HIGHWAYHASH_BACKEND_COUNT] = {
+    [HIGHWAYHASH_BACKEND_PORTABLE] = "portable",
+    [HIGHWAYHASH_BACKEND_AVX2] = "avx2",
+    [HIGHWAYHASH_BACKEND_AVX512] = "avx512",
+    [HIGHWAYHASH_BACKEND_SSE41] = "sse41",
+};
+
+/* Fastest first, the portable backend is always available */
+static const HighwayHashBackend kPreference[] = {
+    HIGHWAYHASH_BACKEND_AVX512,
+    HIGHWAYHASH_BACKEND_AVX2,
+    HIGHWAYHASH_BACKEND_SSE41,
+    HIGHWAYHASH_BACKEND_PORTABLE,
+};
+
+static void CpuInit(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+#endif
+}
+
+static const HighwayHashBackendOps *
+BackendOps(HighwayHashBackend backend) {
+  switch (backend) {
+  case HIGHWAYHASH_BACKEND_PORTABLE:
+    return &kHighwayHashPortableOps;
+#ifdef HIGHWAYHASH_HAVE_SSE41
+  case HIGHWAYHASH_BACKEND_SSE41:
+    return __builtin_cpu_supports("sse4.1") ? &kHighwayHashSse41Ops : NULL;
+#endif
+#ifdef HIGHWAYHASH_HAVE_AVX2
+  case HIGHWAYHASH_BACKEND_AVX2:
+    return __builtin_cpu_supports("avx2") ? &kHighwayHashAvx2Ops : NULL;
+#endif
+#ifdef HIGHWAYHASH_HAVE_AVX512
+  case HIGHWAYHASH_BACKEND_AVX512:
+    return __builtin_cpu_supports("avx512f") &&
+                   __builtin_cpu_supports("avx512vl") &&
+                   __builtin_cpu_supports("avx512bw")
+               ? &kHighwayHashAvx512Ops
+               : NULL;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+/* Portable until the constructor below has run, so calls made from other
+   constructors still get correct results. */
+static const HighwayHashBackendOps *ops = &kHighwayHashPortableOps;
+static HighwayHashBackend current = HIGHWAYHASH_BACKEND_PORTABLE;
 
-  size_t i = 0;
-  while (i + 32 <= size) {
-    HighwayHashUpdatePacket(state, data + i);
+__attribute__((constructor)) static void SelectBackend(void) {
+  CpuInit();
+  for (size_t i = 0; i < sizeof(kPreference) / sizeof(kPreference[0]); i++) {
+    if (HighwayHashSetBackend(kPreference[i]) == 0) {
+      return;
+    }
+  }
+}
+
+HighwayHashBackend HighwayHashGetBackend(void) { return current; }
 
-    i += 32;
+int HighwayHashBackendAvailable(HighwayHashBackend backend) {
+  CpuInit();
+  return BackendOps(backend) != NULL;
+}
+
+int HighwayHashSetBackend(HighwayHashBackend backend) {
+  const HighwayHashBackendOps *selected = BackendOps(backend);
+  if (selected == NULL) {
+    return -1;
   }
-  if ((size & 31) != 0) {
-    HighwayHashUpdateRemainder(state, data + i, size & 31);
+  ops = selected;
+  current = backend;
+  return 0;
+}
+
+const char *HighwayHashBackendName(HighwayHashBackend backend) {
+  if ((unsigned)backend >= HIGHWAYHASH_BACKEND_COUNT) {
+    return "unknown";
   }
+  return kBackendNames[backend];
 }
 
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Low-level API, use for implementing streams etc...                         */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+void HighwayHashReset(HighwayHashState *restrict state,
+                      const uint64_t *restrict key) {
+  ops->reset(state, key);
+}
+
+void HighwayHashUpdatePacket(HighwayHashState *restrict state,
+                             const uint8_t *restrict packet) {
+  ops->update_packets(state, packet, 1);
+}
+
+void HighwayHashUpdateRemainder(HighwayHashState *restrict state,
+                                const uint8_t *restrict bytes,
+                                size_t size_mod32) {
+  ops->update_remainder(state, bytes, size_mod32);
+}
+
+uint64_t HighwayHashFinalize64(HighwayHashState *restrict state) {
+  HIGHWAYHASH_STATS_BEGIN();
+  const uint64_t hash = ops->finalize64(state);
+  HIGHWAYHASH_STATS_END(FINALIZE64, 0);
+  return hash;
+}
+
+void HighwayHashFinalize128(HighwayHashState *restrict state,
+                            uint64_t *restrict hash) {
+  HIGHWAYHASH_STATS_BEGIN();
+  ops->finalize128(state, hash);
+  HIGHWAYHASH_STATS_END(FINALIZE128, 0);
+}
+
+void HighwayHashFinalize256(HighwayHashState *restrict state,
+                            uint64_t *restrict hash) {
+  HIGHWAYHASH_STATS_BEGIN();
+  ops->finalize256(state, hash);
+  HIGHWAYHASH_STATS_END(FINALIZE256, 0);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Non-cat API: single call on full data                                      */
+/*////////////////////////////////////////////////////////////////////////////*/
+
 uint64_t HighwayHash64(const uint8_t *restrict data, size_t size,
                        const uint64_t *restrict key) {
-  HighwayHashState state;
-  ProcessAll(&state, data, size, key);
-  return HighwayHashFinalize64(&state);
+  HIGHWAYHASH_STATS_BEGIN();
+  const uint64_t hash = ops->hash64(data, size, key);
+  HIGHWAYHASH_STATS_END(HASH64, size);
+  return hash;
 }
 
 void HighwayHash128(const uint8_t *restrict data, size_t size,
                     const uint64_t *restrict key, uint64_t *restrict hash) {
-  HighwayHashState state;
-  ProcessAll(&state, data, size, key);
-  HighwayHashFinalize128(&state, hash);
+  HIGHWAYHASH_STATS_BEGIN();
+  ops->hash128(data, size, key, hash);
+  HIGHWAYHASH_STATS_END(HASH128, size);
 }
 
 void HighwayHash256(const uint8_t *data, size_t size,
                     const uint64_t *restrict key, uint64_t *restrict hash) {
-  HighwayHashState state;
-  ProcessAll(&state, data, size, key);
-  HighwayHashFinalize256(&state, hash);
+  HIGHWAYHASH_STATS_BEGIN();
+  ops->hash256(data, size, key, hash);
+  HIGHWAYHASH_STATS_END(HASH256, size);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Pre-keyed API: skips the key setup when one key is used for many calls     */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+void HighwayHashKeyInit(HighwayHashKey *restrict hkey,
+                        const uint64_t *restrict key) {
+  ops->reset(&hkey->state, key);
+}
+
+uint64_t HighwayHash64WithKey(const uint8_t *restrict data, size_t size,
+                              const HighwayHashKey *restrict hkey) {
+  HIGHWAYHASH_STATS_BEGIN();
+  const uint64_t hash = ops->hash64_keyed(&hkey->state, data, size);
+  HIGHWAYHASH_STATS_END(HASH64, size);
+  return hash;
+}
+
+void HighwayHash128WithKey(const uint8_t *restrict data, size_t size,
+                           const HighwayHashKey *restrict hkey,
+                           uint64_t *restrict hash) {
+  HIGHWAYHASH_STATS_BEGIN();
+  ops->hash128_keyed(&hkey->state, data, size, hash);
+  HIGHWAYHASH_STATS_END(HASH128, size);
+}
+
+void HighwayHash256WithKey(const uint8_t *restrict data, size_t size,
+                           const HighwayHashKey *restrict hkey,
+                           uint64_t *restrict hash) {
+  HIGHWAYHASH_STATS_BEGIN();
+  ops->hash256_keyed(&hkey->state, data, size, hash);
+  HIGHWAYHASH_STATS_END(HASH256, size);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Fixed-width API: single packet inputs of a size known at compile time      */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static inline uint64_t Read64(const uint8_t *restrict src) {
+  return (uint64_t)src[0] | ((uint64_t)src[1] << 8) | ((uint64_t)src[2] << 16) |
+         ((uint64_t)src[3] << 24) | ((uint64_t)src[4] << 32) |
+         ((uint64_t)src[5] << 40) | ((uint64_t)src[6] << 48) |
+         ((uint64_t)src[7] << 56);
+}
+
+/* The remainder packet of a 4, 8 or 16 byte message holds its whole 4-byte
+   words in order. For 16 bytes the last word is repeated in bytes 28..31. */
+
+uint64_t HighwayHash64_U32(uint32_t value, const uint64_t *restrict key) {
+  return ops->hash64_packet(value, 0, 0, 0, 4, key);
+}
+
+uint64_t HighwayHash64_U64(uint64_t value, const uint64_t *restrict key) {
+  return ops->hash64_packet(value, 0, 0, 0, 8, key);
+}
+
+uint64_t HighwayHash64_16B(const uint8_t *restrict data,
+                           const uint64_t *restrict key) {
+  const uint64_t hi = Read64(data + 8);
+  return ops->hash64_packet(Read64(data), hi, 0, hi & 0xFFFFFFFF00000000,
+                            16, key);
+}
+
+uint64_t HighwayHash64_32B(const uint8_t *restrict data,
+                           const uint64_t *restrict key) {
+  return ops->hash64_packet(Read64(data), Read64(data + 8),
+                            Read64(data + 16), Read64(data + 24), 0, key);
+}
+
+void HighwayHash128_U32(uint32_t value, const uint64_t *restrict key,
+                        uint64_t *restrict hash) {
+  ops->hash128_packet(value, 0, 0, 0, 4, key, hash);
+}
+
+void HighwayHash128_U64(uint64_t value, const uint64_t *restrict key,
+                        uint64_t *restrict hash) {
+  ops->hash128_packet(value, 0, 0, 0, 8, key, hash);
+}
+
+void HighwayHash128_16B(const uint8_t *restrict data,
+                        const uint64_t *restrict key, uint64_t *restrict hash) {
+  const uint64_t hi = Read64(data + 8);
+  ops->hash128_packet(Read64(data), hi, 0, hi & 0xFFFFFFFF00000000, 16, key,
+                      hash);
+}
+
+void HighwayHash128_32B(const uint8_t *restrict data,
+                        const uint64_t *restrict key, uint64_t *restrict hash) {
+  ops->hash128_packet(Read64(data), Read64(data + 8), Read64(data + 16),
+                      Read64(data + 24), 0, key, hash);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Batch API: many independent messages with the same key                     */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+void HighwayHash64Batch(const uint8_t *const *data, const size_t *sizes,
+                        size_t count, const uint64_t *restrict key,
+                        uint64_t *restrict hashes) {
+  HighwayHashState start;
+  ops->reset(&start, key);
+  ops->hash64_batch(&start, data, sizes, count, hashes);
+}
+
+void HighwayHash128Batch(const uint8_t *const *data, const size_t *sizes,
+                         size_t count, const uint64_t *restrict key,
+                         uint64_t *restrict hashes) {
+  HighwayHashState start;
+  ops->reset(&start, key);
+  ops->hash128_batch(&start, data, sizes, count, hashes);
+}
+
+void HighwayHash64BatchWithKey(const uint8_t *const *data, const size_t *sizes,
+                               size_t count,
+                               const HighwayHashKey *restrict hkey,
+                               uint64_t *restrict hashes) {
+  ops->hash64_batch(&hkey->state, data, sizes, count, hashes);
+}
+
+void HighwayHash128BatchWithKey(const uint8_t *const *data,
+                                const size_t *sizes, size_t count,
+                                const HighwayHashKey *restrict hkey,
+                                uint64_t *restrict hashes) {
+  ops->hash128_batch(&hkey->state, data, sizes, count, hashes);
+}
+
+void HighwayHash64MultiKey(const uint8_t *restrict data, size_t size,
+                           const uint64_t *restrict keys, size_t k,
+                           uint64_t *restrict hashes) {
+  ops->hash64_multikey(data, size, keys, k, hashes);
 }
 
 /*////////////////////////////////////////////////////////////////////////////*/
@@ -50,58 +300,218 @@ void HighwayHash256(const uint8_t *data, size_t size,
 
 void HighwayHashCatStart(HighwayHashCat *restrict state,
                          const uint64_t *restrict key) {
-  HighwayHashReset(&state->state, key);
+  ops->reset(&state->state, key);
   state->num = 0;
 }
 
-void HighwayHashCatAppend(HighwayHashCat *restrict state,
-                          const uint8_t *restrict bytes, size_t num) {
+void HighwayHashCatStartWithKey(HighwayHashCat *restrict state,
+                                const HighwayHashKey *restrict hkey) {
+  memcpy(&state->state, &hkey->state, sizeof(state->state));
+  state->num = 0;
+}
+
+/* Only a packet split between calls is staged in state->packet, full
+   packets are hashed straight from the caller's memory. */
+static inline void CatAppend(HighwayHashCat *restrict state,
+                             const uint8_t *restrict bytes, size_t num) {
+  if (num == 0) {
+    return; // bytes may be NULL
+  }
   if (state->num != 0) {
     size_t num_add = num > (32u - state->num) ? (32u - state->num) : num;
-    for (size_t i = 0; i < num_add; i++) {
-      state->packet[state->num + i] = bytes[i];
-    }
+    memcpy(state->packet + state->num, bytes, num_add);
     state->num += num_add;
     num -= num_add;
     bytes += num_add;
     if (state->num == 32) {
-      HighwayHashUpdatePacket(&state->state, state->packet);
+      ops->update_packets(&state->state, state->packet, 1);
       state->num = 0;
     }
   }
-  while (num >= 32) {
-    HighwayHashUpdatePacket(&state->state, bytes);
-    num -= 32;
-    bytes += 32;
+  if (num >= 32) {
+    ops->update_packets(&state->state, bytes, num / 32);
+    bytes += num & ~(size_t)31;
+    num &= 31;
   }
-  for (size_t i = 0; i < num; i++) {
-    state->packet[state->num] = bytes[i];
-    state->num++;
+  memcpy(state->packet + state->num, bytes, num);
+  state->num += num;
+}
+
+void HighwayHashCatAppend(HighwayHashCat *restrict state,
+                          const uint8_t *restrict bytes, size_t num) {
+  HIGHWAYHASH_STATS_BEGIN();
+  CatAppend(state, bytes, num);
+  HIGHWAYHASH_STATS_END(CAT_APPEND, num);
+}
+
+void HighwayHashCatAppendV(HighwayHashCat *restrict state,
+                           const struct iovec *iov, int iovcnt) {
+  HIGHWAYHASH_STATS_BEGIN();
+  size_t total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    CatAppend(state, iov[i].iov_base, iov[i].iov_len);
+    total += iov[i].iov_len;
   }
+  HIGHWAYHASH_STATS_END(CAT_APPEND, total);
+  (void)total;
 }
 
 uint64_t HighwayHashCatFinish64(const HighwayHashCat *state) {
+  HIGHWAYHASH_STATS_BEGIN();
   HighwayHashState copy = state->state;
   if (state->num) {
-    HighwayHashUpdateRemainder(&copy, state->packet, state->num);
+    ops->update_remainder(&copy, state->packet, state->num);
   }
-  return HighwayHashFinalize64(&copy);
+  const uint64_t hash = ops->finalize64(&copy);
+  HIGHWAYHASH_STATS_END(CAT_FINISH64, state->num);
+  return hash;
 }
 
 void HighwayHashCatFinish128(const HighwayHashCat *state,
                              uint64_t *restrict hash) {
+  HIGHWAYHASH_STATS_BEGIN();
   HighwayHashState copy = state->state;
   if (state->num) {
-    HighwayHashUpdateRemainder(&copy, state->packet, state->num);
+    ops->update_remainder(&copy, state->packet, state->num);
   }
-  HighwayHashFinalize128(&copy, hash);
+  ops->finalize128(&copy, hash);
+  HIGHWAYHASH_STATS_END(CAT_FINISH128, state->num);
 }
 
 void HighwayHashCatFinish256(const HighwayHashCat *state,
                              uint64_t *restrict hash) {
+  HIGHWAYHASH_STATS_BEGIN();
   HighwayHashState copy = state->state;
   if (state->num) {
-    HighwayHashUpdateRemainder(&copy, state->packet, state->num);
+    ops->update_remainder(&copy, state->packet, state->num);
+  }
+  ops->finalize256(&copy, hash);
+  HIGHWAYHASH_STATS_END(CAT_FINISH256, state->num);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Cat state serialization                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Version 1 layout, every integer little-endian:
+
+     0    4  magic "HHCS"
+     4    1  version
+     5    1  staged bytes, 0..31
+     6    2  zero
+     8  128  v0[4], v1[4], mul0[4], mul1[4]
+   136   32  staged bytes, zero-padded
+   168    8  HighwayHash64 of bytes 0..167 under kSerializeKey
+
+   The checksum catches truncated or corrupted files, it is no MAC. The zero
+   bytes must be zero, so later versions can give them a meaning. */
+
+#define kSerializeVersion 1
+#define kSerializeChecksumOffset (HIGHWAYHASH_CAT_SERIALIZED_SIZE - 8)
+
+static const uint8_t kSerializeMagic[4] = {'H', 'H', 'C', 'S'};
+static const uint64_t kSerializeKey[4] = {1, 2, 3, 4};
+
+static inline void Write64(uint8_t *restrict dst, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    dst[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+void HighwayHashCatSerialize(const HighwayHashCat *restrict state,
+                             uint8_t *restrict bytes) {
+  const uint64_t *const words[4] = {state->state.v0, state->state.v1,
+                                    state->state.mul0, state->state.mul1};
+  memset(bytes, 0, HIGHWAYHASH_CAT_SERIALIZED_SIZE);
+  memcpy(bytes, kSerializeMagic, sizeof(kSerializeMagic));
+  bytes[4] = kSerializeVersion;
+  bytes[5] = (uint8_t)state->num;
+  for (int i = 0; i < 16; i++) {
+    Write64(bytes + 8 + 8 * i, words[i / 4][i % 4]);
+  }
+  memcpy(bytes + 136, state->packet, state->num);
+  Write64(bytes + kSerializeChecksumOffset,
+          ops->hash64(bytes, kSerializeChecksumOffset, kSerializeKey));
+}
+
+static int AllZero(const uint8_t *bytes, size_t size) {
+  uint8_t any = 0;
+  for (size_t i = 0; i < size; i++) {
+    any |= bytes[i];
+  }
+  return any == 0;
+}
+
+int HighwayHashCatDeserialize(HighwayHashCat *restrict state,
+                              const uint8_t *restrict bytes, size_t size) {
+  if (size != HIGHWAYHASH_CAT_SERIALIZED_SIZE ||
+      memcmp(bytes, kSerializeMagic, sizeof(kSerializeMagic)) != 0 ||
+      bytes[4] != kSerializeVersion || bytes[5] >= 32 ||
+      !AllZero(bytes + 6, 2) ||
+      !AllZero(bytes + 136 + bytes[5], 32 - (size_t)bytes[5]) ||
+      Read64(bytes + kSerializeChecksumOffset) !=
+          ops->hash64(bytes, kSerializeChecksumOffset, kSerializeKey)) {
+    return -1;
+  }
+  uint64_t *const words[4] = {state->state.v0, state->state.v1,
+                              state->state.mul0, state->state.mul1};
+  for (int i = 0; i < 16; i++) {
+    words[i / 4][i % 4] = Read64(bytes + 8 + 8 * i);
+  }
+  state->num = bytes[5];
+  memcpy(state->packet, bytes + 136, 32);
+  return 0;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Prefix API: hashes of many prefixes in one sequential pass                 */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Each checkpoint is finalized on a copy of the state. Nothing in the main
+   update loop depends on that copy, so the CPU overlaps its finalization
+   with the next segment's packets. */
+void HighwayHashCatAppendPrefixes64(HighwayHashCat *restrict state,
+                                    const uint8_t *restrict bytes, size_t num,
+                                    const size_t *restrict offsets,
+                                    size_t count, uint64_t *restrict hashes) {
+  size_t done = 0;
+  for (size_t i = 0; i < count; i++) {
+    CatAppend(state, bytes + done, offsets[i] - done);
+    done = offsets[i];
+    hashes[i] = HighwayHashCatFinish64(state);
+  }
+  CatAppend(state, bytes + done, num - done);
+}
+
+void HighwayHashCatAppendPrefixes128(HighwayHashCat *restrict state,
+                                     const uint8_t *restrict bytes, size_t num,
+                                     const size_t *restrict offsets,
+                                     size_t count, uint64_t *restrict hashes) {
+  size_t done = 0;
+  for (size_t i = 0; i < count; i++) {
+    CatAppend(state, bytes + done, offsets[i] - done);
+    done = offsets[i];
+    HighwayHashCatFinish128(state, hashes + 2 * i);
   }
-  HighwayHashFinalize256(&copy, hash);
+  CatAppend(state, bytes + done, num - done);
+}
+
+void HighwayHash64Prefixes(const uint8_t *restrict data,
+                           const size_t *restrict offsets, size_t count,
+                           const uint64_t *restrict key,
+                           uint64_t *restrict hashes) {
+  HighwayHashCat cat;
+  HighwayHashCatStart(&cat, key);
+  HighwayHashCatAppendPrefixes64(&cat, data, count ? offsets[count - 1] : 0,
+                                 offsets, count, hashes);
+}
+
+void HighwayHash128Prefixes(const uint8_t *restrict data,
+                            const size_t *restrict offsets, size_t count,
+                            const uint64_t *restrict key,
+                            uint64_t *restrict hashes) {
+  HighwayHashCat cat;
+  HighwayHashCatStart(&cat, key);
+  HighwayHashCatAppendPrefixes128(&cat, data, count ? offsets[count - 1] : 0,
+                                  offsets, count, hashes);
 }
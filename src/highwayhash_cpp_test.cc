@@ -0,0 +1,96 @@
+#include "hh_c/highwayhash.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+constexpr hh_c::Key kTestKey1(0x0706050403020100, 0x0F0E0D0C0B0A0908,
+                              0x1716151413121110, 0x1F1E1D1C1B1A1918);
+
+/* Bytes 0, 1, 2, ... as in the C test, which holds the expected values */
+constexpr char kData[65] = {
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16,
+    17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33,
+    34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50,
+    51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64};
+
+constexpr std::string_view Prefix(size_t size) { return {kData, size}; }
+
+// Every code path of the constexpr version: empty, partial word only, full
+// packet, packet plus remainders with and without a partial word.
+static_assert(hh_c::HighwayHash(Prefix(0), kTestKey1) == 0x907A56DE22C26E53);
+static_assert(hh_c::HighwayHash(Prefix(3), kTestKey1) == 0x5C6BEFAB8A463D80);
+static_assert(hh_c::HighwayHash(Prefix(15), kTestKey1) == 0x40793F86A449F33B);
+static_assert(hh_c::HighwayHash(Prefix(31), kTestKey1) == 0x9FC7007CCF035A68);
+static_assert(hh_c::HighwayHash(Prefix(32), kTestKey1) == 0xA0C964D9ECD580FC);
+static_assert(hh_c::HighwayHash(Prefix(33), kTestKey1) == 0x2C90F73CA03181FC);
+static_assert(hh_c::HighwayHash(Prefix(52), kTestKey1) == 0x582E5483707BC0E9);
+static_assert(hh_c::HighwayHash(Prefix(64), kTestKey1) == 0x75542C5D4CD2A6FF);
+
+enum Command { kStart, kStop, kUnknown };
+
+Command Parse(std::string_view word) {
+  switch (hh_c::HighwayHash(word, kTestKey1)) {
+  case hh_c::HighwayHash("start", kTestKey1):
+    return word == "start" ? kStart : kUnknown;
+  case hh_c::HighwayHash("stop", kTestKey1):
+    return word == "stop" ? kStop : kUnknown;
+  default:
+    return kUnknown;
+  }
+}
+
+void Fail(const char *what, size_t size) {
+  std::printf("Test failed: C++ %s, size %d, backend: %s\n", what, (int)size,
+              HighwayHashBackendName(HighwayHashGetBackend()));
+  std::exit(1);
+}
+
+template <size_t Bits> void TestRuntime() {
+  for (size_t size = 0; size <= 64; size++) {
+    // The constexpr code evaluated at run time against the backend.
+    const hh_c::Hash<Bits> expected =
+        hh_c::detail::Compute<Bits>(Prefix(size), size, kTestKey1);
+    if (hh_c::HighwayHash<Bits>(Prefix(size), kTestKey1) != expected) {
+      Fail("runtime", size);
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  for (int b = 0; b < HIGHWAYHASH_BACKEND_COUNT; b++) {
+    if (HighwayHashSetBackend(static_cast<HighwayHashBackend>(b)) != 0) {
+      continue;
+    }
+    TestRuntime<64>();
+    TestRuntime<128>();
+    TestRuntime<256>();
+  }
+
+  if (Parse("start") != kStart || Parse("stop") != kStop ||
+      Parse("pause") != kUnknown) {
+    Fail("switch", 0);
+  }
+
+  std::unordered_map<std::string, int, hh_c::Hasher> map(
+      16, hh_c::Hasher(kTestKey1));
+  map["one"] = 1;
+  map["two"] = 2;
+  if (map.at("one") != 1 || map.at("two") != 2 || map.count("three") != 0) {
+    Fail("unordered_map", 0);
+  }
+  const hh_c::Hasher hasher(kTestKey1);
+  if (hasher(std::string_view(kData, 7)) !=
+      static_cast<size_t>(hh_c::HighwayHash(Prefix(7), kTestKey1))) {
+    Fail("hasher", 7);
+  }
+
+  std::printf("Test success\n");
+  return 0;
+}
@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 199309L
+#include "hh_c/highwayhash.h"
+#include "highwayhash_bench_util.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Differential test of every available backend against the portable one:
+
+     hh_c_diff_test [--seed N] [--rounds N]
+
+   Each round hashes every length from 0 to kMaxLength under a fresh random
+   key, at a random alignment, through the one-shot, pre-keyed and Cat APIs,
+   the last with the input cut at random split points. A failure prints the
+   seed, which reproduces it. */
+
+#define kMaxLength 4096
+#define kMaxAlign 64
+#define kNumCuts 3
+
+typedef struct {
+  uint64_t hash64;
+  uint64_t hash128[2];
+  uint64_t hash256[4];
+} Hashes;
+
+static void OneShot(const uint8_t *data, size_t size, const uint64_t *key,
+                    Hashes *hashes) {
+  hashes->hash64 = HighwayHash64(data, size, key);
+  HighwayHash128(data, size, key, hashes->hash128);
+  HighwayHash256(data, size, key, hashes->hash256);
+}
+
+static void WithKey(const uint8_t *data, size_t size, const uint64_t *key,
+                    Hashes *hashes) {
+  HighwayHashKey hkey;
+  HighwayHashKeyInit(&hkey, key);
+  hashes->hash64 = HighwayHash64WithKey(data, size, &hkey);
+  HighwayHash128WithKey(data, size, &hkey, hashes->hash128);
+  HighwayHash256WithKey(data, size, &hkey, hashes->hash256);
+}
+
+/* cuts are ascending offsets into data, the pieces between them are
+   appended one at a time. */
+static void Cat(const uint8_t *data, size_t size, const uint64_t *key,
+                const size_t *cuts, Hashes *hashes) {
+  HighwayHashCat cat;
+  HighwayHashCatStart(&cat, key);
+  size_t begin = 0;
+  for (int i = 0; i < kNumCuts; i++) {
+    HighwayHashCatAppend(&cat, data + begin, cuts[i] - begin);
+    begin = cuts[i];
+  }
+  HighwayHashCatAppend(&cat, data + begin, size - begin);
+  hashes->hash64 = HighwayHashCatFinish64(&cat);
+  HighwayHashCatFinish128(&cat, hashes->hash128);
+  HighwayHashCatFinish256(&cat, hashes->hash256);
+}
+
+static void Compare(const Hashes *expected, const Hashes *actual,
+                    const char *api, size_t size, uint64_t seed) {
+  if (memcmp(expected, actual, sizeof(Hashes)) == 0) {
+    return;
+  }
+  printf("Test failed: %s differs from portable, size: %d, backend: %s, "
+         "seed: %" PRIu64 "\n",
+         api, (int)size, HighwayHashBackendName(HighwayHashGetBackend()),
+         seed);
+  printf("  64-bit: %016" PRIx64 " expected %016" PRIx64 "\n",
+         actual->hash64, expected->hash64);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  uint64_t seed = 0x48485F43;
+  int rounds = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = (uint64_t)strtoull(argv[++i], NULL, 0);
+    } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+      rounds = atoi(argv[++i]);
+    } else {
+      Usage(argv[0], "[--seed N] [--rounds N]");
+    }
+  }
+
+  const HighwayHashBackend best = HighwayHashGetBackend();
+  static uint8_t buffer[kMaxLength + kMaxAlign];
+  uint64_t rng = seed;
+  for (size_t i = 0; i < sizeof(buffer); i++) {
+    buffer[i] = (uint8_t)SplitMix64(&rng);
+  }
+
+  for (int r = 0; r < rounds; r++) {
+    for (size_t size = 0; size <= kMaxLength; size++) {
+      uint64_t key[4];
+      for (int i = 0; i < 4; i++) {
+        key[i] = SplitMix64(&rng);
+      }
+      const uint8_t *data = buffer + SplitMix64(&rng) % kMaxAlign;
+      size_t cuts[kNumCuts];
+      for (int i = 0; i < kNumCuts; i++) {
+        cuts[i] = (size_t)(SplitMix64(&rng) % (size + 1));
+        // Insertion keeps the cuts ascending.
+        for (int j = i; j > 0 && cuts[j - 1] > cuts[j]; j--) {
+          const size_t swap = cuts[j];
+          cuts[j] = cuts[j - 1];
+          cuts[j - 1] = swap;
+        }
+      }
+
+      Hashes expected;
+      HighwayHashSetBackend(HIGHWAYHASH_BACKEND_PORTABLE);
+      OneShot(data, size, key, &expected);
+      for (int b = 0; b < HIGHWAYHASH_BACKEND_COUNT; b++) {
+        if (HighwayHashSetBackend((HighwayHashBackend)b) != 0) {
+          continue;
+        }
+        Hashes actual;
+        OneShot(data, size, key, &actual);
+        Compare(&expected, &actual, "one-shot", size, seed);
+        WithKey(data, size, key, &actual);
+        Compare(&expected, &actual, "pre-keyed", size, seed);
+        Cat(data, size, key, cuts, &actual);
+        Compare(&expected, &actual, "Cat", size, seed);
+      }
+    }
+  }
+  HighwayHashSetBackend(best);
+
+  printf("Test success\n");
+  return 0;
+}
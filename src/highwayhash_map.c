@@ -0,0 +1,232 @@
+#define _DEFAULT_SOURCE
+#include "hh_c/highwayhash_map.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define kGroupSize 16
+#define kEmpty 0x80
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+#if defined(__SSE2__)
+static inline uint32_t MatchByte(const uint8_t *group, uint8_t byte) {
+  const __m128i ctrl = _mm_loadu_si128((const __m128i_u *)group);
+  return (uint32_t)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+}
+
+// Only empty slots have the top bit set.
+static inline uint32_t MatchEmpty(const uint8_t *group) {
+  return (uint32_t)_mm_movemask_epi8(
+      _mm_loadu_si128((const __m128i_u *)group));
+}
+#else
+static inline uint32_t MatchByte(const uint8_t *group, uint8_t byte) {
+  uint32_t mask = 0;
+  for (int i = 0; i < kGroupSize; i++) {
+    mask |= (uint32_t)(group[i] == byte) << i;
+  }
+  return mask;
+}
+
+static inline uint32_t MatchEmpty(const uint8_t *group) {
+  uint32_t mask = 0;
+  for (int i = 0; i < kGroupSize; i++) {
+    mask |= (uint32_t)(group[i] >> 7) << i;
+  }
+  return mask;
+}
+#endif
+
+static inline uint64_t Hash(const HighwayHashMap *map, const uint8_t *key,
+                            size_t key_size) {
+  return HighwayHash64WithKey(key, key_size, &map->hkey);
+}
+
+static inline size_t Capacity(const HighwayHashMap *map) {
+  return map->ctrl != NULL ? (map->group_mask + 1) * kGroupSize : 0;
+}
+
+/* Groups are probed at triangular offsets 0, 1, 3, 6, ..., which visit every
+   group once when their number is a power of two. Returns the slot of key,
+   or SIZE_MAX. */
+static size_t FindSlot(const HighwayHashMap *map, uint64_t hash,
+                       const uint8_t *key, size_t key_size) {
+  if (map->ctrl == NULL) {
+    return SIZE_MAX;
+  }
+  const uint8_t h2 = hash & 0x7F;
+  size_t group = (size_t)(hash >> 7) & map->group_mask;
+  for (size_t step = 0; step <= map->group_mask; step++) {
+    const uint8_t *ctrl = map->ctrl + group * kGroupSize;
+    for (uint32_t match = MatchByte(ctrl, h2); match != 0;
+         match &= match - 1) {
+      const size_t slot = group * kGroupSize + (size_t)__builtin_ctz(match);
+      const HighwayHashMapEntry *entry = &map->slots[slot];
+      if (entry->key_size == key_size &&
+          memcmp(entry->key, key, key_size) == 0) {
+        return slot;
+      }
+    }
+    if (map->overflow[group] == 0) {
+      break;
+    }
+    group = (group + step + 1) & map->group_mask;
+  }
+  return SIZE_MAX;
+}
+
+/* Places a key that is known to be absent, there must be a free slot. */
+static void Place(HighwayHashMap *map, uint64_t hash, const uint8_t *key,
+                  size_t key_size, void *value) {
+  size_t group = (size_t)(hash >> 7) & map->group_mask;
+  for (size_t step = 0;; step++) {
+    const uint32_t empty = MatchEmpty(map->ctrl + group * kGroupSize);
+    if (empty != 0) {
+      const size_t slot = group * kGroupSize + (size_t)__builtin_ctz(empty);
+      map->ctrl[slot] = hash & 0x7F;
+      map->slots[slot].key = key;
+      map->slots[slot].key_size = key_size;
+      map->slots[slot].value = value;
+      return;
+    }
+    map->overflow[group]++;
+    group = (group + step + 1) & map->group_mask;
+  }
+}
+
+/* Doubles the number of groups and rehashes every entry into them. */
+static int Grow(HighwayHashMap *map) {
+  const size_t old_capacity = Capacity(map);
+  const size_t groups = map->ctrl != NULL ? 2 * (map->group_mask + 1) : 1;
+  if (groups > SIZE_MAX / (kGroupSize * sizeof(HighwayHashMapEntry))) {
+    return -1;
+  }
+  uint8_t *ctrl = malloc(groups * kGroupSize);
+  size_t *overflow = calloc(groups, sizeof(size_t));
+  HighwayHashMapEntry *slots =
+      malloc(groups * kGroupSize * sizeof(HighwayHashMapEntry));
+  if (ctrl == NULL || overflow == NULL || slots == NULL) {
+    free(ctrl);
+    free(overflow);
+    free(slots);
+    return -1;
+  }
+  memset(ctrl, kEmpty, groups * kGroupSize);
+
+  HighwayHashMap old = *map;
+  map->ctrl = ctrl;
+  map->overflow = overflow;
+  map->slots = slots;
+  map->group_mask = groups - 1;
+  for (size_t i = 0; i < old_capacity; i++) {
+    if (old.ctrl[i] != kEmpty) {
+      const HighwayHashMapEntry *entry = &old.slots[i];
+      Place(map, Hash(map, entry->key, entry->key_size), entry->key,
+            entry->key_size, entry->value);
+    }
+  }
+  free(old.ctrl);
+  free(old.overflow);
+  free(old.slots);
+  return 0;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Hash map API                                                               */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+int HighwayHashMapInit(HighwayHashMap *map, const uint64_t *key) {
+  uint64_t random_key[4];
+  if (key == NULL) {
+    if (getentropy(random_key, sizeof(random_key)) != 0) {
+      return -1;
+    }
+    key = random_key;
+  }
+  HighwayHashKeyInit(&map->hkey, key);
+  map->ctrl = NULL;
+  map->overflow = NULL;
+  map->slots = NULL;
+  map->group_mask = 0;
+  map->size = 0;
+  return 0;
+}
+
+void HighwayHashMapFree(HighwayHashMap *map) {
+  free(map->ctrl);
+  free(map->overflow);
+  free(map->slots);
+  map->ctrl = NULL;
+  map->overflow = NULL;
+  map->slots = NULL;
+  map->group_mask = 0;
+  map->size = 0;
+}
+
+void **HighwayHashMapFind(const HighwayHashMap *map, const uint8_t *key,
+                          size_t key_size) {
+  const size_t slot = FindSlot(map, Hash(map, key, key_size), key, key_size);
+  return slot != SIZE_MAX ? &map->slots[slot].value : NULL;
+}
+
+int HighwayHashMapInsert(HighwayHashMap *map, const uint8_t *key,
+                         size_t key_size, void *value) {
+  const uint64_t hash = Hash(map, key, key_size);
+  const size_t slot = FindSlot(map, hash, key, key_size);
+  if (slot != SIZE_MAX) {
+    map->slots[slot].value = value;
+    return 0;
+  }
+  // Keep at least one slot in eight free so probe sequences stay short.
+  const size_t capacity = Capacity(map);
+  if (map->size >= capacity - capacity / 8) {
+    if (Grow(map) != 0) {
+      return -1;
+    }
+  }
+  Place(map, hash, key, key_size, value);
+  map->size++;
+  return 1;
+}
+
+int HighwayHashMapErase(HighwayHashMap *map, const uint8_t *key,
+                        size_t key_size) {
+  const uint64_t hash = Hash(map, key, key_size);
+  const size_t slot = FindSlot(map, hash, key, key_size);
+  if (slot == SIZE_MAX) {
+    return 0;
+  }
+  map->ctrl[slot] = kEmpty;
+  map->size--;
+
+  // Undo the overflow counts Place added on the way to the key's group.
+  const size_t target = slot / kGroupSize;
+  size_t group = (size_t)(hash >> 7) & map->group_mask;
+  for (size_t step = 0; group != target; step++) {
+    map->overflow[group]--;
+    group = (group + step + 1) & map->group_mask;
+  }
+  return 1;
+}
+
+const HighwayHashMapEntry *HighwayHashMapNext(const HighwayHashMap *map,
+                                              size_t *iter) {
+  const size_t capacity = Capacity(map);
+  while (*iter < capacity) {
+    const size_t slot = (*iter)++;
+    if (map->ctrl[slot] != kEmpty) {
+      return &map->slots[slot];
+    }
+  }
+  return NULL;
+}
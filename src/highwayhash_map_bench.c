@@ -0,0 +1,231 @@
+#define _POSIX_C_SOURCE 199309L
+#include "hh_c/highwayhash_map.h"
+#include "highwayhash_bench_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Compares HighwayHashMap with a plain linear probing table that uses the
+   same hash, load factor and key layout, and prints one record per (table,
+   operation, keys) as CSV or JSON lines:
+
+     hh_c_map_bench [--json] [--max-keys N]
+
+   Keys are 16 random bytes, like UUIDs. Every operation is run once over
+   all keys and the fastest of kRepetitions runs is kept. */
+
+#define kKeySize 16
+#define kRepetitions 3
+
+static const uint64_t kKey[4] = {0x0706050403020100, 0x0F0E0D0C0B0A0908,
+                                 0x1716151413121110, 0x1F1E1D1C1B1A1918};
+
+typedef enum { kInsert, kFindHit, kFindMiss, kErase, kNumOperations } Operation;
+
+static const char *const kOperationNames[kNumOperations] = {
+    "insert", "find_hit", "find_miss", "erase"};
+
+static volatile uintptr_t sink;
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Linear probing baseline                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* One slot per entry, an empty slot has key == NULL. Erasing shifts the
+   following entries back, so this baseline needs no tombstones either. */
+typedef struct {
+  HighwayHashKey hkey;
+  HighwayHashMapEntry *slots;
+  size_t mask;
+  size_t size;
+} LinearMap;
+
+static size_t LinearHome(const LinearMap *map, const uint8_t *key,
+                         size_t key_size) {
+  return (size_t)HighwayHash64WithKey(key, key_size, &map->hkey) & map->mask;
+}
+
+static size_t LinearFind(const LinearMap *map, const uint8_t *key,
+                         size_t key_size) {
+  if (map->slots == NULL) {
+    return SIZE_MAX;
+  }
+  for (size_t i = LinearHome(map, key, key_size);; i = (i + 1) & map->mask) {
+    const HighwayHashMapEntry *entry = &map->slots[i];
+    if (entry->key == NULL) {
+      return SIZE_MAX;
+    }
+    if (entry->key_size == key_size &&
+        memcmp(entry->key, key, key_size) == 0) {
+      return i;
+    }
+  }
+}
+
+static void LinearPlace(LinearMap *map, const HighwayHashMapEntry *entry) {
+  size_t i = LinearHome(map, entry->key, entry->key_size);
+  while (map->slots[i].key != NULL) {
+    i = (i + 1) & map->mask;
+  }
+  map->slots[i] = *entry;
+}
+
+static int LinearInsert(LinearMap *map, const uint8_t *key, size_t key_size,
+                        void *value) {
+  const size_t found = LinearFind(map, key, key_size);
+  if (found != SIZE_MAX) {
+    map->slots[found].value = value;
+    return 0;
+  }
+  const size_t capacity = map->slots != NULL ? map->mask + 1 : 0;
+  if (map->size >= capacity - capacity / 8) {
+    const size_t new_capacity = capacity != 0 ? 2 * capacity : 16;
+    HighwayHashMapEntry *old = map->slots;
+    map->slots = calloc(new_capacity, sizeof(HighwayHashMapEntry));
+    if (map->slots == NULL) {
+      map->slots = old;
+      return -1;
+    }
+    map->mask = new_capacity - 1;
+    for (size_t i = 0; i < capacity; i++) {
+      if (old[i].key != NULL) {
+        LinearPlace(map, &old[i]);
+      }
+    }
+    free(old);
+  }
+  const HighwayHashMapEntry entry = {key, key_size, value};
+  LinearPlace(map, &entry);
+  map->size++;
+  return 1;
+}
+
+static int LinearErase(LinearMap *map, const uint8_t *key, size_t key_size) {
+  size_t hole = LinearFind(map, key, key_size);
+  if (hole == SIZE_MAX) {
+    return 0;
+  }
+  for (size_t i = (hole + 1) & map->mask; map->slots[i].key != NULL;
+       i = (i + 1) & map->mask) {
+    const HighwayHashMapEntry *entry = &map->slots[i];
+    const size_t home = LinearHome(map, entry->key, entry->key_size);
+    // Move the entry back unless its home lies cyclically in (hole, i].
+    if (((i - home) & map->mask) >= ((i - hole) & map->mask)) {
+      map->slots[hole] = *entry;
+      hole = i;
+    }
+  }
+  map->slots[hole].key = NULL;
+  map->size--;
+  return 1;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Benchmark driver                                                           */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Runs every operation once over all keys of a fresh table and stores the
+   total time of each in ns. present holds the keys to insert, absent keys
+   that are never inserted. */
+static void RunSwiss(const uint8_t *present, const uint8_t *absent,
+                     size_t num, double *ns) {
+  HighwayHashMap map;
+  HighwayHashMapInit(&map, kKey);
+  double start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    HighwayHashMapInsert(&map, present + i * kKeySize, kKeySize, NULL);
+  }
+  ns[kInsert] = NowNs() - start;
+  start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    sink += (uintptr_t)HighwayHashMapFind(&map, present + i * kKeySize,
+                                          kKeySize);
+  }
+  ns[kFindHit] = NowNs() - start;
+  start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    sink +=
+        (uintptr_t)HighwayHashMapFind(&map, absent + i * kKeySize, kKeySize);
+  }
+  ns[kFindMiss] = NowNs() - start;
+  start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    HighwayHashMapErase(&map, present + i * kKeySize, kKeySize);
+  }
+  ns[kErase] = NowNs() - start;
+  HighwayHashMapFree(&map);
+}
+
+static void RunLinear(const uint8_t *present, const uint8_t *absent,
+                      size_t num, double *ns) {
+  LinearMap map = {.slots = NULL, .mask = 0, .size = 0};
+  HighwayHashKeyInit(&map.hkey, kKey);
+  double start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    LinearInsert(&map, present + i * kKeySize, kKeySize, NULL);
+  }
+  ns[kInsert] = NowNs() - start;
+  start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    sink += LinearFind(&map, present + i * kKeySize, kKeySize);
+  }
+  ns[kFindHit] = NowNs() - start;
+  start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    sink += LinearFind(&map, absent + i * kKeySize, kKeySize);
+  }
+  ns[kFindMiss] = NowNs() - start;
+  start = NowNs();
+  for (size_t i = 0; i < num; i++) {
+    LinearErase(&map, present + i * kKeySize, kKeySize);
+  }
+  ns[kErase] = NowNs() - start;
+  free(map.slots);
+}
+
+typedef void (*RunFunction)(const uint8_t *, const uint8_t *, size_t,
+                            double *);
+
+int main(int argc, char **argv) {
+  int json = 0;
+  size_t max_keys = (size_t)1 << 20;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0) {
+      json = 1;
+    } else if (strcmp(argv[i], "--max-keys") == 0 && i + 1 < argc) {
+      max_keys = (size_t)strtoull(argv[++i], NULL, 0);
+    } else {
+      Usage(argv[0], "[--json] [--max-keys N]");
+    }
+  }
+
+  uint8_t *present = AllocOrExit(max_keys * kKeySize);
+  uint8_t *absent = AllocOrExit(max_keys * kKeySize);
+  uint64_t seed = 1;
+  RandomBytes(&seed, present, max_keys * kKeySize);
+  RandomBytes(&seed, absent, max_keys * kKeySize);
+
+  static const char *const kTables[] = {"swiss", "linear"};
+  static const RunFunction kRuns[] = {RunSwiss, RunLinear};
+  for (size_t num = 1024; num <= max_keys; num *= 16) {
+    for (int t = 0; t < 2; t++) {
+      double best[kNumOperations];
+      for (int r = 0; r < kRepetitions; r++) {
+        double ns[kNumOperations];
+        kRuns[t](present, absent, num, ns);
+        KeepFastest(best, ns, kNumOperations, r);
+      }
+      for (int op = 0; op < kNumOperations; op++) {
+        const BenchField fields[] = {
+            {"table", kTables[t], 0.0, 0},
+            {"operation", kOperationNames[op], 0.0, 0},
+            {"keys", NULL, (double)num, 0},
+            {"ns_per_op", NULL, best[op] / (double)num, 3}};
+        PrintRecord(json, fields, sizeof(fields) / sizeof(fields[0]));
+      }
+    }
+  }
+  free(present);
+  free(absent);
+  return 0;
+}
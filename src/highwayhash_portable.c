@@ -1,5 +1,4 @@
-#define HIGHWAYHASH_PORTABLE
-#include "hh_c/highwayhash.h"
+#include "highwayhash_backend.h"
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -9,8 +8,8 @@
 /* Internal implementation                                                    */
 /*////////////////////////////////////////////////////////////////////////////*/
 
-void HighwayHashReset(HighwayHashState *restrict state,
-                      const uint64_t *restrict key) {
+static void PortableReset(HighwayHashState *restrict state,
+                          const uint64_t *restrict key) {
   state->mul0[0] = 0xdbe6d5d5fe4cce2f;
   state->mul0[1] = 0xa4093822299f31d0;
   state->mul0[2] = 0x13198a2e03707344;
@@ -25,114 +24,207 @@ void HighwayHashReset(HighwayHashState *restrict state,
   }
 }
 
-void ZipperMergeAndAdd(const uint64_t v1, const uint64_t v0,
-                       uint64_t *restrict add1, uint64_t *restrict add0) {
-  *add0 += (((v0 & 0xff000000) | (v1 & 0xff00000000)) >> 24) |
-           (((v0 & 0xff0000000000) | (v1 & 0xff000000000000)) >> 16) |
-           (v0 & 0xff0000) | ((v0 & 0xff00) << 32) |
-           ((v1 & 0xff00000000000000) >> 8) | (v0 << 56);
-  *add1 += (((v1 & 0xff000000) | (v0 & 0xff00000000)) >> 24) | (v1 & 0xff0000) |
-           ((v1 & 0xff0000000000) >> 16) | ((v1 & 0xff00) << 24) |
-           ((v0 & 0xff000000000000) >> 8) | ((v1 & 0xff) << 48) |
-           (v0 & 0xff00000000000000);
+/* The code below is written as fixed-count loops over the four lanes of
+   each state array, with every cross-lane step expressed as a constant
+   index table. Compilers turn these into vector adds, 32x32->64 multiplies
+   and byte shuffles for whatever the target offers, so -O3 -march=native
+   builds approach the hand-written backends without any intrinsics. The
+   byte table only pays off where it becomes a single shuffle instruction,
+   elsewhere the zipper merge stays shifts and masks. */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ &&   \
+    (defined(__SSSE3__) || defined(__ARM_NEON) || defined(__ALTIVEC__) ||     \
+     defined(__wasm_simd128__) || defined(__riscv_vector))
+/* Source byte of each output byte, per 128-bit pair of lanes */
+static const uint8_t kZipperMerge[32] = {
+    3,  12, 2,  5,  14, 1,  15, 0,  11, 4,  10, 13, 9,  6,  8,  7,
+    19, 28, 18, 21, 30, 17, 31, 16, 27, 20, 26, 29, 25, 22, 24, 23};
+
+static void ZipperMergeAndAdd(const uint64_t *restrict v,
+                              uint64_t *restrict add) {
+  uint8_t bytes[32];
+  uint8_t merged_bytes[32];
+  uint64_t merged[4];
+  memcpy(bytes, v, sizeof(bytes));
+  // Fully unrolled, the table becomes one constant byte shuffle.
+#pragma GCC unroll 32
+  for (int i = 0; i < 32; i++) {
+    merged_bytes[i] = bytes[kZipperMerge[i]];
+  }
+  memcpy(merged, merged_bytes, sizeof(merged));
+  for (int i = 0; i < 4; i++) {
+    add[i] += merged[i];
+  }
+}
+#else
+static void ZipperMergeAndAdd(const uint64_t *restrict v,
+                              uint64_t *restrict add) {
+  for (int i = 0; i < 4; i += 2) {
+    const uint64_t v0 = v[i];
+    const uint64_t v1 = v[i + 1];
+    add[i] += (((v0 & 0xff000000) | (v1 & 0xff00000000)) >> 24) |
+              (((v0 & 0xff0000000000) | (v1 & 0xff000000000000)) >> 16) |
+              (v0 & 0xff0000) | ((v0 & 0xff00) << 32) |
+              ((v1 & 0xff00000000000000) >> 8) | (v0 << 56);
+    add[i + 1] += (((v1 & 0xff000000) | (v0 & 0xff00000000)) >> 24) |
+                  (v1 & 0xff0000) | ((v1 & 0xff0000000000) >> 16) |
+                  ((v1 & 0xff00) << 24) | ((v0 & 0xff000000000000) >> 8) |
+                  ((v1 & 0xff) << 48) | (v0 & 0xff00000000000000);
+  }
 }
+#endif
 
-void Update(HighwayHashState *restrict state, const uint64_t *restrict lanes) {
+/* Kept out of line: inlined into a loop, the state is promoted to scalar
+   registers and the stores the vectorizer starts from disappear. */
+__attribute__((noinline)) static void
+Update(HighwayHashState *restrict state, const uint64_t *restrict lanes) {
   for (int i = 0; i < 4; ++i) {
     state->v1[i] += state->mul0[i] + lanes[i];
     state->mul0[i] ^= (state->v1[i] & 0xffffffff) * (state->v0[i] >> 32);
     state->v0[i] += state->mul1[i];
     state->mul1[i] ^= (state->v0[i] & 0xffffffff) * (state->v1[i] >> 32);
   }
-  ZipperMergeAndAdd(state->v1[1], state->v1[0], &state->v0[1], &state->v0[0]);
-  ZipperMergeAndAdd(state->v1[3], state->v1[2], &state->v0[3], &state->v0[2]);
-  ZipperMergeAndAdd(state->v0[1], state->v0[0], &state->v1[1], &state->v1[0]);
-  ZipperMergeAndAdd(state->v0[3], state->v0[2], &state->v1[3], &state->v1[2]);
+  ZipperMergeAndAdd(state->v1, state->v0);
+  ZipperMergeAndAdd(state->v0, state->v1);
 }
 
-uint64_t Read64(const uint8_t *restrict src) {
+/* Little-endian loads. Where the byte order is known at compile time they
+   are a single unaligned load, plus a byte swap on big-endian targets. */
+static inline uint64_t Load64LE(const uint8_t *restrict src) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t value;
+  memcpy(&value, src, sizeof(value));
+  return value;
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  uint64_t value;
+  memcpy(&value, src, sizeof(value));
+  return __builtin_bswap64(value);
+#else
   return (uint64_t)src[0] | ((uint64_t)src[1] << 8) | ((uint64_t)src[2] << 16) |
          ((uint64_t)src[3] << 24) | ((uint64_t)src[4] << 32) |
          ((uint64_t)src[5] << 40) | ((uint64_t)src[6] << 48) |
          ((uint64_t)src[7] << 56);
+#endif
 }
 
-void HighwayHashUpdatePacket(HighwayHashState *restrict state,
-                             const uint8_t *restrict packet) {
+static inline uint32_t Load32LE(const uint8_t *restrict src) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint32_t value;
+  memcpy(&value, src, sizeof(value));
+  return value;
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  uint32_t value;
+  memcpy(&value, src, sizeof(value));
+  return __builtin_bswap32(value);
+#else
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+         ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+#endif
+}
+
+static void PortableUpdatePacket(HighwayHashState *restrict state,
+                                 const uint8_t *restrict packet) {
   uint64_t lanes[4];
-  lanes[0] = Read64(packet + 0);
-  lanes[1] = Read64(packet + 8);
-  lanes[2] = Read64(packet + 16);
-  lanes[3] = Read64(packet + 24);
+  lanes[0] = Load64LE(packet + 0);
+  lanes[1] = Load64LE(packet + 8);
+  lanes[2] = Load64LE(packet + 16);
+  lanes[3] = Load64LE(packet + 24);
   Update(state, lanes);
 }
 
-void Rotate32By(uint64_t count, uint64_t lanes[4]) {
-  for (int i = 0; i < 4; ++i) {
-    uint32_t half0 = lanes[i] & 0xffffffff;
-    uint32_t half1 = (lanes[i] >> 32);
-    lanes[i] = (half0 << count) | (half0 >> (32 - count));
-    lanes[i] |= (uint64_t)((half1 << count) | (half1 >> (32 - count))) << 32;
+/* count is 1..31. Every 32-bit half is rotated alike, so the halves can be
+   handled as one array of eight words whatever the byte order. */
+static void Rotate32By(uint64_t count, uint64_t lanes[4]) {
+  uint32_t halves[8];
+  memcpy(halves, lanes, sizeof(halves));
+  for (int i = 0; i < 8; ++i) {
+    halves[i] = (halves[i] << count) | (halves[i] >> (32 - count));
   }
+  memcpy(lanes, halves, sizeof(halves));
 }
 
-void HighwayHashUpdateRemainder(HighwayHashState *restrict state,
-                                const uint8_t *restrict bytes,
-                                const size_t size_mod32) {
-  const size_t size_mod4 = size_mod32 & 3;
-  const uint8_t *remainder = bytes + (size_mod32 & ~3);
-  uint8_t packet[32] = {0};
+static void InjectSize(HighwayHashState *restrict state,
+                       const size_t size_mod32) {
   for (int i = 0; i < 4; ++i) {
     state->v0[i] += ((uint64_t)size_mod32 << 32) + size_mod32;
   }
   Rotate32By(size_mod32, state->v1);
-  for (int i = 0; i < remainder - bytes; i++) {
-    packet[i] = bytes[i];
+}
+
+/* Shifting the four bytes that end at the last input byte right by
+   kTailShift[size_mod4] leaves just the partial word of a remainder. */
+static const uint8_t kTailShift[4] = {0, 24, 16, 8};
+
+/* Lays out the zero-padded remainder packet of a size_mod32 byte tail */
+static void RemainderLanes(const uint8_t *restrict bytes,
+                           const size_t size_mod32, uint64_t lanes[4]) {
+  const size_t size_mod4 = size_mod32 & 3;
+  const size_t whole = size_mod32 & ~(size_t)3;
+  lanes[0] = lanes[1] = lanes[2] = lanes[3] = 0;
+
+  // The whole 4-byte words are copied as they are.
+  size_t i = 0;
+  for (; 8 * i + 8 <= whole; i++) {
+    lanes[i] = Load64LE(bytes + 8 * i);
+  }
+  if (whole & 4) {
+    lanes[i] = Load32LE(bytes + 8 * i);
   }
+
   if (size_mod32 & 16) {
-    for (int i = 0; i < 4; i++) {
-      packet[28 + i] = remainder[i + size_mod4 - 4];
-    }
-  } else {
-    if (size_mod4) {
-      packet[16 + 0] = remainder[0];
-      packet[16 + 1] = remainder[size_mod4 >> 1];
-      packet[16 + 2] = remainder[size_mod4 - 1];
-    }
+    lanes[3] |= (uint64_t)Load32LE(bytes + size_mod32 - 4) << 32;
+  } else if (size_mod32 >= 4 && size_mod4) {
+    // Bytes 16..18 are the first, middle and last byte of the partial
+    // word. One load that overlaps the whole words replaces three.
+    const uint32_t tail =
+        Load32LE(bytes + size_mod32 - 4) >> kTailShift[size_mod4];
+    lanes[2] = (tail & 0xFF) | ((tail >> (8 * (size_mod4 >> 1)) & 0xFF) << 8) |
+               ((uint64_t)(tail >> (8 * (size_mod4 - 1))) << 16);
+  } else if (size_mod4) {
+    const uint8_t *remainder = bytes + whole;
+    lanes[2] = (uint64_t)remainder[0] |
+               ((uint64_t)remainder[size_mod4 >> 1] << 8) |
+               ((uint64_t)remainder[size_mod4 - 1] << 16);
   }
-  HighwayHashUpdatePacket(state, packet);
+}
+
+static void PortableUpdateRemainder(HighwayHashState *restrict state,
+                                    const uint8_t *restrict bytes,
+                                    const size_t size_mod32) {
+  uint64_t lanes[4];
+  RemainderLanes(bytes, size_mod32, lanes);
+  InjectSize(state, size_mod32);
+  Update(state, lanes);
 }
 
 static void Permute(const uint64_t *restrict v, uint64_t *restrict permuted) {
-  permuted[0] = (v[2] >> 32) | (v[2] << 32);
-  permuted[1] = (v[3] >> 32) | (v[3] << 32);
-  permuted[2] = (v[0] >> 32) | (v[0] << 32);
-  permuted[3] = (v[1] >> 32) | (v[1] << 32);
+  for (int i = 0; i < 4; i++) {
+    permuted[i] = (v[i ^ 2] >> 32) | (v[i ^ 2] << 32);
+  }
 }
 
-void PermuteAndUpdate(HighwayHashState *restrict state) {
+static void PermuteAndUpdate(HighwayHashState *restrict state) {
   uint64_t permuted[4];
   Permute(state->v0, permuted);
   Update(state, permuted);
 }
 
-void ModularReduction(uint64_t a3_unmasked, uint64_t a2, uint64_t a1,
-                      uint64_t a0, uint64_t *restrict m1,
-                      uint64_t *restrict m0) {
+static void ModularReduction(uint64_t a3_unmasked, uint64_t a2, uint64_t a1,
+                             uint64_t a0, uint64_t *restrict m1,
+                             uint64_t *restrict m0) {
   uint64_t a3 = a3_unmasked & 0x3FFFFFFFFFFFFFFF;
   *m1 = a1 ^ ((a3 << 1) | (a2 >> 63)) ^ ((a3 << 2) | (a2 >> 62));
   *m0 = a0 ^ (a2 << 1) ^ (a2 << 2);
 }
 
-uint64_t HighwayHashFinalize64(HighwayHashState *restrict state) {
+static uint64_t PortableFinalize64(HighwayHashState *restrict state) {
   for (int i = 0; i < 4; i++) {
     PermuteAndUpdate(state);
   }
   return state->v0[0] + state->v1[0] + state->mul0[0] + state->mul1[0];
 }
 
-void HighwayHashFinalize128(HighwayHashState *restrict state,
-                            uint64_t *restrict hash) {
+static void PortableFinalize128(HighwayHashState *restrict state,
+                               uint64_t *restrict hash) {
   for (int i = 0; i < 6; i++) {
     PermuteAndUpdate(state);
   }
@@ -140,8 +232,8 @@ void HighwayHashFinalize128(HighwayHashState *restrict state,
   hash[1] = state->v0[1] + state->mul0[1] + state->v1[3] + state->mul1[3];
 }
 
-void HighwayHashFinalize256(HighwayHashState *restrict state,
-                            uint64_t *restrict hash) {
+static void PortableFinalize256(HighwayHashState *restrict state,
+                               uint64_t *restrict hash) {
   /* We anticipate that 256-bit hashing will be mostly used with long messages
      because storing and using the 256-bit hash (in contrast to 128-bit)
      carries a larger additional constant cost by itself. Doing extra rounds
@@ -156,3 +248,244 @@ void HighwayHashFinalize256(HighwayHashState *restrict state,
                    state->v0[3] + state->mul0[3], state->v0[2] + state->mul0[2],
                    &hash[3], &hash[2]);
 }
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Backend entry points                                                       */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static void PortableUpdatePackets(HighwayHashState *restrict state,
+                                  const uint8_t *restrict packets,
+                                  size_t num_packets) {
+  for (size_t i = 0; i < num_packets; i++) {
+    PortableUpdatePacket(state, packets + i * 32);
+  }
+}
+
+static void ProcessData(HighwayHashState *restrict state,
+                        const uint8_t *restrict data, size_t size) {
+  PortableUpdatePackets(state, data, size / 32);
+  if ((size & 31) != 0) {
+    PortableUpdateRemainder(state, data + (size & ~(size_t)31), size & 31);
+  }
+}
+
+static void ProcessAll(HighwayHashState *restrict state,
+                       const uint8_t *restrict data, size_t size,
+                       const uint64_t *restrict key) {
+  PortableReset(state, key);
+  ProcessData(state, data, size);
+}
+
+static uint64_t PortableHash64(const uint8_t *restrict data, size_t size,
+                               const uint64_t *restrict key) {
+  HighwayHashState state;
+  ProcessAll(&state, data, size, key);
+  return PortableFinalize64(&state);
+}
+
+static void PortableHash128(const uint8_t *restrict data, size_t size,
+                            const uint64_t *restrict key,
+                            uint64_t *restrict hash) {
+  HighwayHashState state;
+  ProcessAll(&state, data, size, key);
+  PortableFinalize128(&state, hash);
+}
+
+static void PortableHash256(const uint8_t *restrict data, size_t size,
+                            const uint64_t *restrict key,
+                            uint64_t *restrict hash) {
+  HighwayHashState state;
+  ProcessAll(&state, data, size, key);
+  PortableFinalize256(&state, hash);
+}
+
+static uint64_t PortableHash64Keyed(const HighwayHashState *restrict start,
+                                    const uint8_t *restrict data, size_t size) {
+  HighwayHashState state = *start;
+  ProcessData(&state, data, size);
+  return PortableFinalize64(&state);
+}
+
+static void PortableHash128Keyed(const HighwayHashState *restrict start,
+                                 const uint8_t *restrict data, size_t size,
+                                 uint64_t *restrict hash) {
+  HighwayHashState state = *start;
+  ProcessData(&state, data, size);
+  PortableFinalize128(&state, hash);
+}
+
+static void PortableHash256Keyed(const HighwayHashState *restrict start,
+                                 const uint8_t *restrict data, size_t size,
+                                 uint64_t *restrict hash) {
+  HighwayHashState state = *start;
+  ProcessData(&state, data, size);
+  PortableFinalize256(&state, hash);
+}
+
+static void ProcessLanes(HighwayHashState *restrict state,
+                         const uint64_t *restrict lanes, size_t size_mod32,
+                         const uint64_t *restrict key) {
+  PortableReset(state, key);
+  if (size_mod32 != 0) {
+    InjectSize(state, size_mod32);
+  }
+  Update(state, lanes);
+}
+
+static uint64_t PortableHash64Packet(uint64_t lane0, uint64_t lane1,
+                                     uint64_t lane2, uint64_t lane3,
+                                     size_t size_mod32,
+                                     const uint64_t *restrict key) {
+  const uint64_t lanes[4] = {lane0, lane1, lane2, lane3};
+  HighwayHashState state;
+  ProcessLanes(&state, lanes, size_mod32, key);
+  return PortableFinalize64(&state);
+}
+
+static void PortableHash128Packet(uint64_t lane0, uint64_t lane1,
+                                  uint64_t lane2, uint64_t lane3,
+                                  size_t size_mod32,
+                                  const uint64_t *restrict key,
+                                  uint64_t *restrict hash) {
+  const uint64_t lanes[4] = {lane0, lane1, lane2, lane3};
+  HighwayHashState state;
+  ProcessLanes(&state, lanes, size_mod32, key);
+  PortableFinalize128(&state, hash);
+}
+
+/* Absorbs up to kHighwayHashBatchLanes messages in lockstep. The states are
+   independent, so the loops over them give the CPU parallel work. */
+static void ProcessBatch(HighwayHashState *restrict states,
+                         const HighwayHashState *restrict init,
+                         const uint8_t *const *data, const size_t *sizes,
+                         size_t num) {
+  size_t max_packets = 0;
+  for (size_t j = 0; j < num; j++) {
+    states[j] = *init;
+    if (sizes[j] / 32 > max_packets) {
+      max_packets = sizes[j] / 32;
+    }
+  }
+  for (size_t p = 0; p < max_packets; p++) {
+    for (size_t j = 0; j < num; j++) {
+      if (p < sizes[j] / 32) {
+        PortableUpdatePacket(&states[j], data[j] + p * 32);
+      }
+    }
+  }
+  for (size_t j = 0; j < num; j++) {
+    if ((sizes[j] & 31) != 0) {
+      PortableUpdateRemainder(&states[j], data[j] + (sizes[j] & ~(size_t)31),
+                              sizes[j] & 31);
+    }
+  }
+}
+
+static void PortableHash64Batch(const HighwayHashState *restrict start,
+                                const uint8_t *const *data,
+                                const size_t *sizes, size_t count,
+                                uint64_t *restrict hashes) {
+  HighwayHashState states[kHighwayHashBatchLanes];
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    ProcessBatch(states, start, data + i, sizes + i, num);
+    for (int r = 0; r < 4; r++) {
+      for (size_t j = 0; j < num; j++) {
+        PermuteAndUpdate(&states[j]);
+      }
+    }
+    for (size_t j = 0; j < num; j++) {
+      hashes[i + j] = states[j].v0[0] + states[j].v1[0] + states[j].mul0[0] +
+                      states[j].mul1[0];
+    }
+  }
+}
+
+static void PortableHash128Batch(const HighwayHashState *restrict start,
+                                 const uint8_t *const *data,
+                                 const size_t *sizes, size_t count,
+                                 uint64_t *restrict hashes) {
+  HighwayHashState states[kHighwayHashBatchLanes];
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    ProcessBatch(states, start, data + i, sizes + i, num);
+    for (int r = 0; r < 6; r++) {
+      for (size_t j = 0; j < num; j++) {
+        PermuteAndUpdate(&states[j]);
+      }
+    }
+    for (size_t j = 0; j < num; j++) {
+      const HighwayHashState *state = &states[j];
+      hashes[2 * (i + j) + 0] =
+          state->v0[0] + state->mul0[0] + state->v1[2] + state->mul1[2];
+      hashes[2 * (i + j) + 1] =
+          state->v0[1] + state->mul0[1] + state->v1[3] + state->mul1[3];
+    }
+  }
+}
+
+/* Hashes one message under k keys, kHighwayHashBatchLanes at a time. Each
+   packet is loaded once per group and fed to all its states, which are
+   independent; the message is read again for every group. */
+static void PortableHash64MultiKey(const uint8_t *restrict data, size_t size,
+                                   const uint64_t *restrict keys, size_t k,
+                                   uint64_t *restrict hashes) {
+  HighwayHashState states[kHighwayHashBatchLanes];
+  uint64_t lanes[4];
+  for (size_t i = 0; i < k; i += kHighwayHashBatchLanes) {
+    const size_t num =
+        k - i < kHighwayHashBatchLanes ? k - i : kHighwayHashBatchLanes;
+    for (size_t j = 0; j < num; j++) {
+      PortableReset(&states[j], keys + 4 * (i + j));
+    }
+    for (size_t p = 0; p + 32 <= size; p += 32) {
+      lanes[0] = Load64LE(data + p + 0);
+      lanes[1] = Load64LE(data + p + 8);
+      lanes[2] = Load64LE(data + p + 16);
+      lanes[3] = Load64LE(data + p + 24);
+      for (size_t j = 0; j < num; j++) {
+        Update(&states[j], lanes);
+      }
+    }
+    if ((size & 31) != 0) {
+      RemainderLanes(data + (size & ~(size_t)31), size & 31, lanes);
+      for (size_t j = 0; j < num; j++) {
+        InjectSize(&states[j], size & 31);
+        Update(&states[j], lanes);
+      }
+    }
+    for (int r = 0; r < 4; r++) {
+      for (size_t j = 0; j < num; j++) {
+        PermuteAndUpdate(&states[j]);
+      }
+    }
+    for (size_t j = 0; j < num; j++) {
+      hashes[i + j] = states[j].v0[0] + states[j].v1[0] + states[j].mul0[0] +
+                      states[j].mul1[0];
+    }
+  }
+}
+
+const HighwayHashBackendOps kHighwayHashPortableOps = {
+    .reset = PortableReset,
+    .update_packets = PortableUpdatePackets,
+    .update_remainder = PortableUpdateRemainder,
+    .finalize64 = PortableFinalize64,
+    .finalize128 = PortableFinalize128,
+    .finalize256 = PortableFinalize256,
+    .hash64 = PortableHash64,
+    .hash128 = PortableHash128,
+    .hash256 = PortableHash256,
+    .hash64_keyed = PortableHash64Keyed,
+    .hash128_keyed = PortableHash128Keyed,
+    .hash256_keyed = PortableHash256Keyed,
+    .hash64_packet = PortableHash64Packet,
+    .hash128_packet = PortableHash128Packet,
+    .hash64_batch = PortableHash64Batch,
+    .hash128_batch = PortableHash128Batch,
+    .hash64_multikey = PortableHash64MultiKey,
+};
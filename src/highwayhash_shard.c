@@ -0,0 +1,98 @@
+#include "hh_c/highwayhash_shard.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Nodes scored per HighwayHash64MultiKey call. The scores stay on the stack
+   and the argmax runs over them while they are hot. */
+#define kChunkNodes 64
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Rendezvous hashing                                                         */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+int HighwayHashRendezvousInit(HighwayHashRendezvous *hrw, const uint64_t *key,
+                              const uint64_t *node_ids, size_t num_nodes) {
+  if (num_nodes == 0 || num_nodes > SIZE_MAX / (4 * sizeof(uint64_t))) {
+    return -1;
+  }
+  uint64_t *node_keys = malloc(num_nodes * 4 * sizeof(uint64_t));
+  uint64_t *ids = malloc(num_nodes * sizeof(uint64_t));
+  if (node_keys == NULL || ids == NULL) {
+    free(node_keys);
+    free(ids);
+    return -1;
+  }
+  for (size_t n = 0; n < num_nodes; n++) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+      bytes[i] = (uint8_t)(node_ids[n] >> (8 * i));
+    }
+    HighwayHash256(bytes, sizeof(bytes), key, node_keys + 4 * n);
+  }
+  memcpy(ids, node_ids, num_nodes * sizeof(uint64_t));
+  hrw->node_keys = node_keys;
+  hrw->node_ids = ids;
+  hrw->num_nodes = num_nodes;
+  return 0;
+}
+
+void HighwayHashRendezvousFree(HighwayHashRendezvous *hrw) {
+  free(hrw->node_keys);
+  free(hrw->node_ids);
+  hrw->node_keys = NULL;
+  hrw->node_ids = NULL;
+  hrw->num_nodes = 0;
+}
+
+void HighwayHashRendezvousScores(const HighwayHashRendezvous *hrw,
+                                 const uint8_t *data, size_t size,
+                                 uint64_t *scores) {
+  HighwayHash64MultiKey(data, size, hrw->node_keys, hrw->num_nodes, scores);
+}
+
+size_t HighwayHashRendezvousLookup(const HighwayHashRendezvous *hrw,
+                                   const uint8_t *data, size_t size) {
+  uint64_t scores[kChunkNodes];
+  size_t best = 0;
+  uint64_t best_score = 0;
+  for (size_t i = 0; i < hrw->num_nodes; i += kChunkNodes) {
+    const size_t num = hrw->num_nodes - i < kChunkNodes ? hrw->num_nodes - i
+                                                        : kChunkNodes;
+    HighwayHash64MultiKey(data, size, hrw->node_keys + 4 * i, num, scores);
+    for (size_t j = 0; j < num; j++) {
+      const size_t n = i + j;
+      if (n == 0 || scores[j] > best_score ||
+          (scores[j] == best_score && hrw->node_ids[n] < hrw->node_ids[best])) {
+        best = n;
+        best_score = scores[j];
+      }
+    }
+  }
+  return best;
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Jump consistent hashing                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* The published algorithm: a linear congruential generator seeded with hash
+   decides after which bucket count the key jumps next. */
+uint32_t HighwayHashJump(uint64_t hash, uint32_t num_buckets) {
+  int64_t b = -1;
+  int64_t j = 0;
+  while (j < (int64_t)num_buckets) {
+    b = j;
+    hash = hash * 2862933555777941757ULL + 1;
+    j = (int64_t)((double)(b + 1) *
+                  ((double)(1LL << 31) / (double)((hash >> 33) + 1)));
+  }
+  return (uint32_t)b;
+}
+
+uint32_t HighwayHashJumpShard(const uint8_t *data, size_t size,
+                              const HighwayHashKey *hkey,
+                              uint32_t num_buckets) {
+  return HighwayHashJump(HighwayHash64WithKey(data, size, hkey), num_buckets);
+}
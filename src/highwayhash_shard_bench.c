@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 199309L
+#include "hh_c/highwayhash_shard.h"
+#include "highwayhash_bench_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Measures shard lookups per second against the node count and prints one
+   record per (method, nodes) as CSV or JSON lines:
+
+     hh_c_shard_bench [--json] [--max-nodes N]
+
+   Request keys are 16 random bytes. "naive" scores every node with its own
+   HighwayHash64 call, "rendezvous" is HighwayHashRendezvousLookup and
+   "jump" is HighwayHashJumpShard. The fastest of kRepetitions runs over all
+   requests is kept. */
+
+#define kKeySize 16
+#define kNumRequests 4096
+#define kRepetitions 5
+
+static const uint64_t kKey[4] = {0x0706050403020100, 0x0F0E0D0C0B0A0908,
+                                 0x1716151413121110, 0x1F1E1D1C1B1A1918};
+
+typedef enum { kNaive, kRendezvous, kJump, kNumMethods } Method;
+
+static const char *const kMethodNames[kNumMethods] = {"naive", "rendezvous",
+                                                      "jump"};
+
+static volatile size_t sink;
+
+/* Rendezvous the way callers do it without the module */
+static size_t NaiveLookup(const HighwayHashRendezvous *hrw,
+                          const uint8_t *data, size_t size) {
+  size_t best = 0;
+  uint64_t best_score = 0;
+  for (size_t n = 0; n < hrw->num_nodes; n++) {
+    const uint64_t score = HighwayHash64(data, size, hrw->node_keys + 4 * n);
+    if (n == 0 || score > best_score) {
+      best = n;
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+static double Run(Method method, const HighwayHashRendezvous *hrw,
+                  const HighwayHashKey *hkey, const uint8_t *requests) {
+  const double start = NowNs();
+  for (size_t i = 0; i < kNumRequests; i++) {
+    const uint8_t *request = requests + i * kKeySize;
+    switch (method) {
+    case kNaive:
+      sink += NaiveLookup(hrw, request, kKeySize);
+      break;
+    case kRendezvous:
+      sink += HighwayHashRendezvousLookup(hrw, request, kKeySize);
+      break;
+    default:
+      sink += HighwayHashJumpShard(request, kKeySize, hkey,
+                                   (uint32_t)hrw->num_nodes);
+      break;
+    }
+  }
+  return NowNs() - start;
+}
+
+int main(int argc, char **argv) {
+  int json = 0;
+  size_t max_nodes = 512;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0) {
+      json = 1;
+    } else if (strcmp(argv[i], "--max-nodes") == 0 && i + 1 < argc) {
+      max_nodes = (size_t)strtoull(argv[++i], NULL, 0);
+    } else {
+      Usage(argv[0], "[--json] [--max-nodes N]");
+    }
+  }
+
+  uint64_t *node_ids = AllocOrExit(max_nodes * sizeof(uint64_t));
+  static uint8_t requests[kNumRequests * kKeySize];
+  uint64_t seed = 1;
+  for (size_t i = 0; i < max_nodes; i++) {
+    node_ids[i] = SplitMix64(&seed);
+  }
+  RandomBytes(&seed, requests, sizeof(requests));
+  HighwayHashKey hkey;
+  HighwayHashKeyInit(&hkey, kKey);
+
+  for (size_t nodes = 8; nodes <= max_nodes; nodes *= 2) {
+    HighwayHashRendezvous hrw;
+    if (HighwayHashRendezvousInit(&hrw, kKey, node_ids, nodes) != 0) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+    for (int m = 0; m < kNumMethods; m++) {
+      double best = 0.0;
+      for (int r = 0; r < kRepetitions; r++) {
+        const double ns = Run((Method)m, &hrw, &hkey, requests);
+        KeepFastest(&best, &ns, 1, r);
+      }
+      const double ns_per_lookup = best / kNumRequests;
+      const BenchField fields[] = {
+          {"method", kMethodNames[m], 0.0, 0},
+          {"nodes", NULL, (double)nodes, 0},
+          {"ns_per_lookup", NULL, ns_per_lookup, 3},
+          {"lookups_per_s", NULL, 1e9 / ns_per_lookup, 0}};
+      PrintRecord(json, fields, sizeof(fields) / sizeof(fields[0]));
+    }
+    HighwayHashRendezvousFree(&hrw);
+  }
+  free(node_ids);
+  return 0;
+}
@@ -0,0 +1,515 @@
+#include "highwayhash_backend.h"
+
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tmmintrin.h>
+
+/* Every 4-lane vector of the state is held as two 128-bit halves, L with
+   lanes 0 and 1 and H with lanes 2 and 3. Apart from the permutation the
+   halves never interact, so each step is just done twice. */
+typedef struct {
+  __m128i v0L;
+  __m128i v0H;
+  __m128i v1L;
+  __m128i v1H;
+  __m128i mul0L;
+  __m128i mul0H;
+  __m128i mul1L;
+  __m128i mul1H;
+} InternalState;
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static inline void InternalLoadState(InternalState *restrict state,
+                                     const HighwayHashState *restrict src) {
+  state->v0L = _mm_loadu_si128((const __m128i_u *)(src->v0 + 0));
+  state->v0H = _mm_loadu_si128((const __m128i_u *)(src->v0 + 2));
+  state->v1L = _mm_loadu_si128((const __m128i_u *)(src->v1 + 0));
+  state->v1H = _mm_loadu_si128((const __m128i_u *)(src->v1 + 2));
+  state->mul0L = _mm_loadu_si128((const __m128i_u *)(src->mul0 + 0));
+  state->mul0H = _mm_loadu_si128((const __m128i_u *)(src->mul0 + 2));
+  state->mul1L = _mm_loadu_si128((const __m128i_u *)(src->mul1 + 0));
+  state->mul1H = _mm_loadu_si128((const __m128i_u *)(src->mul1 + 2));
+}
+
+static inline void InternalStoreState(HighwayHashState *restrict dst,
+                                      const InternalState *restrict state) {
+  _mm_storeu_si128((__m128i_u *)(dst->v0 + 0), state->v0L);
+  _mm_storeu_si128((__m128i_u *)(dst->v0 + 2), state->v0H);
+  _mm_storeu_si128((__m128i_u *)(dst->v1 + 0), state->v1L);
+  _mm_storeu_si128((__m128i_u *)(dst->v1 + 2), state->v1H);
+  _mm_storeu_si128((__m128i_u *)(dst->mul0 + 0), state->mul0L);
+  _mm_storeu_si128((__m128i_u *)(dst->mul0 + 2), state->mul0H);
+  _mm_storeu_si128((__m128i_u *)(dst->mul1 + 0), state->mul1L);
+  _mm_storeu_si128((__m128i_u *)(dst->mul1 + 2), state->mul1H);
+}
+
+static inline __m128i Rotate64By32(const __m128i v) {
+  return _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static inline void InternalHighwayHashReset(InternalState *restrict state,
+                                            const uint64_t *restrict key) {
+  const __m128i keyL = _mm_loadu_si128((const __m128i_u *)(key + 0));
+  const __m128i keyH = _mm_loadu_si128((const __m128i_u *)(key + 2));
+  state->mul0L = _mm_set_epi64x(0xa4093822299f31d0, 0xdbe6d5d5fe4cce2f);
+  state->mul0H = _mm_set_epi64x(0x243f6a8885a308d3, 0x13198a2e03707344);
+  state->mul1L = _mm_set_epi64x(0xc0acf169b5f18a8c, 0x3bd39e10cb0ef593);
+  state->mul1H = _mm_set_epi64x(0x452821e638d01377, 0xbe5466cf34e90c6c);
+  state->v0L = _mm_xor_si128(state->mul0L, keyL);
+  state->v0H = _mm_xor_si128(state->mul0H, keyH);
+  state->v1L = _mm_xor_si128(state->mul1L, Rotate64By32(keyL));
+  state->v1H = _mm_xor_si128(state->mul1H, Rotate64By32(keyH));
+}
+
+static inline void InternalZipperMergeAndAdd(__m128i *restrict va,
+                                             const __m128i *restrict vb) {
+  const long long hi = 0x070806090D0A040B;
+  const long long lo = 0x000F010E05020C03;
+  *va = _mm_add_epi64(*va, _mm_shuffle_epi8(*vb, _mm_set_epi64x(hi, lo)));
+}
+
+static inline void InternalUpdate(InternalState *restrict state,
+                                  const __m128i lanesL, const __m128i lanesH) {
+  // state->v1 += state->mul0 + lanes
+  state->v1L = _mm_add_epi64(state->v1L, _mm_add_epi64(state->mul0L, lanesL));
+  state->v1H = _mm_add_epi64(state->v1H, _mm_add_epi64(state->mul0H, lanesH));
+
+  // state->mul0 ^= (state->v1 & 0xffffffff) * (state->v0 >> 32)
+  state->mul0L = _mm_xor_si128(
+      state->mul0L, _mm_mul_epu32(state->v1L, _mm_srli_epi64(state->v0L, 32)));
+  state->mul0H = _mm_xor_si128(
+      state->mul0H, _mm_mul_epu32(state->v1H, _mm_srli_epi64(state->v0H, 32)));
+
+  state->v0L = _mm_add_epi64(state->v0L, state->mul1L);
+  state->v0H = _mm_add_epi64(state->v0H, state->mul1H);
+
+  // state->mul1 ^= (state->v0 & 0xffffffff) * (state->v1 >> 32)
+  state->mul1L = _mm_xor_si128(
+      state->mul1L, _mm_mul_epu32(state->v0L, _mm_srli_epi64(state->v1L, 32)));
+  state->mul1H = _mm_xor_si128(
+      state->mul1H, _mm_mul_epu32(state->v0H, _mm_srli_epi64(state->v1H, 32)));
+
+  InternalZipperMergeAndAdd(&state->v0L, &state->v1L);
+  InternalZipperMergeAndAdd(&state->v0H, &state->v1H);
+  InternalZipperMergeAndAdd(&state->v1L, &state->v0L);
+  InternalZipperMergeAndAdd(&state->v1H, &state->v0H);
+}
+
+static inline void
+InternalHighwayHashUpdatePacket(InternalState *restrict state,
+                                const uint8_t *restrict packet) {
+  InternalUpdate(state, _mm_loadu_si128((const __m128i_u *)(packet + 0)),
+                 _mm_loadu_si128((const __m128i_u *)(packet + 16)));
+}
+
+static inline __m128i InternalRotate32By(const __m128i lanes,
+                                         const __m128i count,
+                                         const __m128i inverse) {
+  return _mm_or_si128(_mm_sll_epi32(lanes, count),
+                      _mm_srl_epi32(lanes, inverse));
+}
+
+static inline void InternalInjectSize(InternalState *restrict state,
+                                      const size_t size_mod32) {
+  const __m128i size_mod32_128 = _mm_set1_epi32((int)size_mod32);
+  // The shift counts are taken from the low 64 bits only.
+  const __m128i count = _mm_cvtsi32_si128((int)size_mod32);
+  const __m128i inverse = _mm_cvtsi32_si128(32 - (int)size_mod32);
+
+  state->v0L = _mm_add_epi64(state->v0L, size_mod32_128);
+  state->v0H = _mm_add_epi64(state->v0H, size_mod32_128);
+
+  state->v1L = InternalRotate32By(state->v1L, count, inverse);
+  state->v1H = InternalRotate32By(state->v1H, count, inverse);
+}
+
+/* Lays out the zero-padded remainder packet of a size_mod32 byte tail */
+static inline void InternalRemainderPacket(const uint8_t *restrict bytes,
+                                           const size_t size_mod32,
+                                           uint8_t *restrict packet) {
+  const size_t size_mod4 = size_mod32 & 3;
+  const uint8_t *remainder = bytes + (size_mod32 & ~3);
+
+  memset(packet, 0, 32);
+  memcpy(packet, bytes, (size_t)(remainder - bytes));
+
+  if (size_mod32 & 16) { // size_mod32 >= 16
+    memcpy(packet + 28, remainder + size_mod4 - 4, 4);
+  } else if (size_mod4) {
+    packet[16 + 0] = remainder[0];
+    packet[16 + 1] = remainder[size_mod4 >> 1];
+    packet[16 + 2] = remainder[size_mod4 - 1];
+  }
+}
+
+static inline void
+InternalHighwayHashUpdateRemainder(InternalState *restrict state,
+                                   const uint8_t *restrict bytes,
+                                   const size_t size_mod32) {
+  alignas(16) uint8_t packet[32];
+  InternalRemainderPacket(bytes, size_mod32, packet);
+  InternalInjectSize(state, size_mod32);
+  InternalHighwayHashUpdatePacket(state, packet);
+}
+
+static inline void InternalPermuteAndUpdate(InternalState *restrict state) {
+  // Swaps the halves and the 32-bit halves of every lane.
+  InternalUpdate(state, Rotate64By32(state->v0H), Rotate64By32(state->v0L));
+}
+
+static inline uint64_t Lane0(const __m128i v) {
+  uint64_t lanes[2];
+  _mm_storeu_si128((__m128i_u *)lanes, v);
+  return lanes[0];
+}
+
+static inline uint64_t
+InternalHighwayHashFinalize64(InternalState *restrict state) {
+  for (int i = 0; i < 4; i++) {
+    InternalPermuteAndUpdate(state);
+  }
+  return Lane0(_mm_add_epi64(_mm_add_epi64(state->v0L, state->v1L),
+                             _mm_add_epi64(state->mul0L, state->mul1L)));
+}
+
+static inline __m128i
+InternalHighwayHashFinalize128(InternalState *restrict state) {
+  for (int i = 0; i < 6; i++) {
+    InternalPermuteAndUpdate(state);
+  }
+  return _mm_add_epi64(_mm_add_epi64(state->v0L, state->mul0L),
+                       _mm_add_epi64(state->v1H, state->mul1H));
+}
+
+// b32a32 holds (a3, a2) and b10a10 holds (a1, a0).
+static inline __m128i ModularReduction(const __m128i b32a32,
+                                       const __m128i b10a10) {
+  const __m128i mask = _mm_set_epi64x(0x3FFFFFFFFFFFFFFF, -1);
+  const __m128i x = _mm_and_si128(b32a32, mask);
+
+  // 128-bit shifts: the bits shifted out of a2 are carried into a3.
+  const __m128i shifted1 = _mm_or_si128(
+      _mm_slli_epi64(x, 1), _mm_slli_si128(_mm_srli_epi64(x, 63), 8));
+  const __m128i shifted2 = _mm_or_si128(
+      _mm_slli_epi64(x, 2), _mm_slli_si128(_mm_srli_epi64(x, 62), 8));
+
+  return _mm_xor_si128(b10a10, _mm_xor_si128(shifted1, shifted2));
+}
+
+static inline void
+InternalHighwayHashFinalize256(InternalState *restrict state,
+                               uint64_t *restrict hash) {
+  for (int i = 0; i < 10; i++) {
+    InternalPermuteAndUpdate(state);
+  }
+  const __m128i sum0L = _mm_add_epi64(state->v0L, state->mul0L);
+  const __m128i sum0H = _mm_add_epi64(state->v0H, state->mul0H);
+  const __m128i sum1L = _mm_add_epi64(state->v1L, state->mul1L);
+  const __m128i sum1H = _mm_add_epi64(state->v1H, state->mul1H);
+  _mm_storeu_si128((__m128i_u *)(hash + 0), ModularReduction(sum1L, sum0L));
+  _mm_storeu_si128((__m128i_u *)(hash + 2), ModularReduction(sum1H, sum0H));
+}
+
+static inline void InternalProcessData(InternalState *restrict state,
+                                       const uint8_t *restrict data,
+                                       size_t size) {
+  size_t i = 0;
+  while (i + 32 <= size) {
+    InternalHighwayHashUpdatePacket(state, data + i);
+    i += 32;
+  }
+  if ((size & 31) != 0) {
+    InternalHighwayHashUpdateRemainder(state, data + i, size & 31);
+  }
+}
+
+static inline void InternalProcessAll(InternalState *restrict state,
+                                      const uint8_t *restrict data,
+                                      size_t size,
+                                      const uint64_t *restrict key) {
+  InternalHighwayHashReset(state, key);
+  InternalProcessData(state, data, size);
+}
+
+static inline void InternalProcessLanes(InternalState *restrict state,
+                                        const __m128i lanesL,
+                                        const __m128i lanesH,
+                                        size_t size_mod32,
+                                        const uint64_t *restrict key) {
+  InternalHighwayHashReset(state, key);
+  if (size_mod32 != 0) {
+    InternalInjectSize(state, size_mod32);
+  }
+  InternalUpdate(state, lanesL, lanesH);
+}
+
+/* Absorbs up to kHighwayHashBatchLanes messages in lockstep so the multiply
+   and shuffle latencies of one message hide behind the others. */
+static inline void InternalProcessBatch(InternalState *restrict states,
+                                        const InternalState *restrict init,
+                                        const uint8_t *const *data,
+                                        const size_t *sizes, size_t num) {
+  size_t max_packets = 0;
+  for (size_t j = 0; j < num; j++) {
+    states[j] = *init;
+    if (sizes[j] / 32 > max_packets) {
+      max_packets = sizes[j] / 32;
+    }
+  }
+  for (size_t p = 0; p < max_packets; p++) {
+    for (size_t j = 0; j < num; j++) {
+      if (p < sizes[j] / 32) {
+        InternalHighwayHashUpdatePacket(&states[j], data[j] + p * 32);
+      }
+    }
+  }
+  for (size_t j = 0; j < num; j++) {
+    if ((sizes[j] & 31) != 0) {
+      InternalHighwayHashUpdateRemainder(
+          &states[j], data[j] + (sizes[j] & ~(size_t)31), sizes[j] & 31);
+    }
+  }
+}
+
+static inline void InternalPermuteAndUpdateBatch(InternalState *restrict states,
+                                                 size_t num, int rounds) {
+  for (int r = 0; r < rounds; r++) {
+    for (size_t j = 0; j < num; j++) {
+      InternalPermuteAndUpdate(&states[j]);
+    }
+  }
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Backend entry points                                                       */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+static void Sse41Reset(HighwayHashState *restrict state,
+                       const uint64_t *restrict key) {
+  InternalState internal;
+  InternalHighwayHashReset(&internal, key);
+  InternalStoreState(state, &internal);
+}
+
+static void Sse41UpdatePackets(HighwayHashState *restrict state,
+                               const uint8_t *restrict packets,
+                               size_t num_packets) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  for (size_t i = 0; i < num_packets; i++) {
+    InternalHighwayHashUpdatePacket(&internal, packets + i * 32);
+  }
+  InternalStoreState(state, &internal);
+}
+
+static void Sse41UpdateRemainder(HighwayHashState *restrict state,
+                                 const uint8_t *restrict bytes,
+                                 size_t size_mod32) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  InternalHighwayHashUpdateRemainder(&internal, bytes, size_mod32);
+  InternalStoreState(state, &internal);
+}
+
+static uint64_t Sse41Finalize64(HighwayHashState *restrict state) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  return InternalHighwayHashFinalize64(&internal);
+}
+
+static void Sse41Finalize128(HighwayHashState *restrict state,
+                             uint64_t *restrict hash) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  _mm_storeu_si128((__m128i_u *)hash,
+                   InternalHighwayHashFinalize128(&internal));
+}
+
+static void Sse41Finalize256(HighwayHashState *restrict state,
+                             uint64_t *restrict hash) {
+  InternalState internal;
+  InternalLoadState(&internal, state);
+  InternalHighwayHashFinalize256(&internal, hash);
+}
+
+static uint64_t Sse41Hash64(const uint8_t *restrict data, size_t size,
+                            const uint64_t *restrict key) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Sse41Hash128(const uint8_t *restrict data, size_t size,
+                         const uint64_t *restrict key,
+                         uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Sse41Hash256(const uint8_t *restrict data, size_t size,
+                         const uint64_t *restrict key,
+                         uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessAll(&state, data, size, key);
+  InternalHighwayHashFinalize256(&state, hash);
+}
+
+static uint64_t Sse41Hash64Keyed(const HighwayHashState *restrict start,
+                                 const uint8_t *restrict data, size_t size) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Sse41Hash128Keyed(const HighwayHashState *restrict start,
+                              const uint8_t *restrict data, size_t size,
+                              uint64_t *restrict hash) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Sse41Hash256Keyed(const HighwayHashState *restrict start,
+                              const uint8_t *restrict data, size_t size,
+                              uint64_t *restrict hash) {
+  InternalState state;
+  InternalLoadState(&state, start);
+  InternalProcessData(&state, data, size);
+  InternalHighwayHashFinalize256(&state, hash);
+}
+
+static uint64_t Sse41Hash64Packet(uint64_t lane0, uint64_t lane1,
+                                  uint64_t lane2, uint64_t lane3,
+                                  size_t size_mod32,
+                                  const uint64_t *restrict key) {
+  InternalState state;
+  InternalProcessLanes(&state,
+                       _mm_set_epi64x((long long)lane1, (long long)lane0),
+                       _mm_set_epi64x((long long)lane3, (long long)lane2),
+                       size_mod32, key);
+  return InternalHighwayHashFinalize64(&state);
+}
+
+static void Sse41Hash128Packet(uint64_t lane0, uint64_t lane1,
+                               uint64_t lane2, uint64_t lane3,
+                               size_t size_mod32,
+                               const uint64_t *restrict key,
+                               uint64_t *restrict hash) {
+  InternalState state;
+  InternalProcessLanes(&state,
+                       _mm_set_epi64x((long long)lane1, (long long)lane0),
+                       _mm_set_epi64x((long long)lane3, (long long)lane2),
+                       size_mod32, key);
+  _mm_storeu_si128((__m128i_u *)hash, InternalHighwayHashFinalize128(&state));
+}
+
+static void Sse41Hash64Batch(const HighwayHashState *restrict start,
+                             const uint8_t *const *data, const size_t *sizes,
+                             size_t count, uint64_t *restrict hashes) {
+  InternalState init;
+  InternalState states[kHighwayHashBatchLanes];
+  InternalLoadState(&init, start);
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    InternalProcessBatch(states, &init, data + i, sizes + i, num);
+    InternalPermuteAndUpdateBatch(states, num, 4);
+    for (size_t j = 0; j < num; j++) {
+      hashes[i + j] =
+          Lane0(_mm_add_epi64(_mm_add_epi64(states[j].v0L, states[j].v1L),
+                              _mm_add_epi64(states[j].mul0L, states[j].mul1L)));
+    }
+  }
+}
+
+static void Sse41Hash128Batch(const HighwayHashState *restrict start,
+                              const uint8_t *const *data, const size_t *sizes,
+                              size_t count, uint64_t *restrict hashes) {
+  InternalState init;
+  InternalState states[kHighwayHashBatchLanes];
+  InternalLoadState(&init, start);
+  for (size_t i = 0; i < count; i += kHighwayHashBatchLanes) {
+    const size_t num = count - i < kHighwayHashBatchLanes
+                           ? count - i
+                           : kHighwayHashBatchLanes;
+    InternalProcessBatch(states, &init, data + i, sizes + i, num);
+    InternalPermuteAndUpdateBatch(states, num, 6);
+    for (size_t j = 0; j < num; j++) {
+      _mm_storeu_si128(
+          (__m128i_u *)(hashes + 2 * (i + j)),
+          _mm_add_epi64(_mm_add_epi64(states[j].v0L, states[j].mul0L),
+                        _mm_add_epi64(states[j].v1H, states[j].mul1H)));
+    }
+  }
+}
+
+/* Hashes one message under k keys, kHighwayHashBatchLanes at a time in
+   lockstep, loading each packet once per group. The message is read again
+   for every group. */
+static void Sse41Hash64MultiKey(const uint8_t *restrict data, size_t size,
+                                const uint64_t *restrict keys, size_t k,
+                                uint64_t *restrict hashes) {
+  InternalState states[kHighwayHashBatchLanes];
+  for (size_t i = 0; i < k; i += kHighwayHashBatchLanes) {
+    const size_t num =
+        k - i < kHighwayHashBatchLanes ? k - i : kHighwayHashBatchLanes;
+    for (size_t j = 0; j < num; j++) {
+      InternalHighwayHashReset(&states[j], keys + 4 * (i + j));
+    }
+    for (size_t p = 0; p + 32 <= size; p += 32) {
+      const __m128i lanesL = _mm_loadu_si128((const __m128i_u *)(data + p));
+      const __m128i lanesH =
+          _mm_loadu_si128((const __m128i_u *)(data + p + 16));
+      for (size_t j = 0; j < num; j++) {
+        InternalUpdate(&states[j], lanesL, lanesH);
+      }
+    }
+    if ((size & 31) != 0) {
+      alignas(16) uint8_t packet[32];
+      InternalRemainderPacket(data + (size & ~(size_t)31), size & 31, packet);
+      const __m128i lanesL = _mm_load_si128((const __m128i *)packet);
+      const __m128i lanesH = _mm_load_si128((const __m128i *)(packet + 16));
+      for (size_t j = 0; j < num; j++) {
+        InternalInjectSize(&states[j], size & 31);
+        InternalUpdate(&states[j], lanesL, lanesH);
+      }
+    }
+    InternalPermuteAndUpdateBatch(states, num, 4);
+    for (size_t j = 0; j < num; j++) {
+      hashes[i + j] =
+          Lane0(_mm_add_epi64(_mm_add_epi64(states[j].v0L, states[j].v1L),
+                              _mm_add_epi64(states[j].mul0L, states[j].mul1L)));
+    }
+  }
+}
+
+const HighwayHashBackendOps kHighwayHashSse41Ops = {
+    .reset = Sse41Reset,
+    .update_packets = Sse41UpdatePackets,
+    .update_remainder = Sse41UpdateRemainder,
+    .finalize64 = Sse41Finalize64,
+    .finalize128 = Sse41Finalize128,
+    .finalize256 = Sse41Finalize256,
+    .hash64 = Sse41Hash64,
+    .hash128 = Sse41Hash128,
+    .hash256 = Sse41Hash256,
+    .hash64_keyed = Sse41Hash64Keyed,
+    .hash128_keyed = Sse41Hash128Keyed,
+    .hash256_keyed = Sse41Hash256Keyed,
+    .hash64_packet = Sse41Hash64Packet,
+    .hash128_packet = Sse41Hash128Packet,
+    .hash64_batch = Sse41Hash64Batch,
+    .hash128_batch = Sse41Hash128Batch,
+    .hash64_multikey = Sse41Hash64MultiKey,
+};
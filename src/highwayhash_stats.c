@@ -0,0 +1,187 @@
+#include "hh_c/highwayhash_stats.h"
+#include "highwayhash_stats_internal.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if HIGHWAYHASH_STATS >= 2 && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define kLevel 2
+#elif HIGHWAYHASH_STATS
+#define kLevel 1
+#else
+#define kLevel 0
+#endif
+
+static const char *const kFunctionNames[HIGHWAYHASH_STATS_COUNT] = {
+    [HIGHWAYHASH_STATS_HASH64] = "hash64",
+    [HIGHWAYHASH_STATS_HASH128] = "hash128",
+    [HIGHWAYHASH_STATS_HASH256] = "hash256",
+    [HIGHWAYHASH_STATS_CAT_APPEND] = "cat_append",
+    [HIGHWAYHASH_STATS_CAT_FINISH64] = "cat_finish64",
+    [HIGHWAYHASH_STATS_CAT_FINISH128] = "cat_finish128",
+    [HIGHWAYHASH_STATS_CAT_FINISH256] = "cat_finish256",
+    [HIGHWAYHASH_STATS_FINALIZE64] = "finalize64",
+    [HIGHWAYHASH_STATS_FINALIZE128] = "finalize128",
+    [HIGHWAYHASH_STATS_FINALIZE256] = "finalize256",
+};
+
+const char *HighwayHashStatsFunctionName(HighwayHashStatsFunction function) {
+  if ((unsigned)function >= HIGHWAYHASH_STATS_COUNT) {
+    return "unknown";
+  }
+  return kFunctionNames[function];
+}
+
+int HighwayHashStatsLevel(void) { return kLevel; }
+
+#if kLevel
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Every counter is a uint64_t, so the stats are summed as a flat array */
+#define kNumCounters (sizeof(HighwayHashStats) / sizeof(uint64_t))
+
+/* Only the owning thread writes a block, with relaxed atomic stores so a
+   concurrent snapshot reads whole values without slowing the writer down
+   with locked instructions. */
+typedef struct ThreadStats {
+  HighwayHashStats stats;
+  struct ThreadStats *prev;
+  struct ThreadStats *next;
+} ThreadStats;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadStats *threads;      /* live threads, guarded by lock */
+static HighwayHashStats retired;  /* exited threads, guarded by lock */
+static HighwayHashStats baseline; /* totals at the last reset, by lock */
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t exit_key;
+static _Thread_local ThreadStats *local;
+
+static void Accumulate(uint64_t *restrict sum,
+                       const HighwayHashStats *restrict stats) {
+  const uint64_t *counters = (const uint64_t *)stats;
+  for (size_t i = 0; i < kNumCounters; i++) {
+    sum[i] += __atomic_load_n(&counters[i], __ATOMIC_RELAXED);
+  }
+}
+
+/* Sums retired and live blocks, lock must be held */
+static void Totals(HighwayHashStats *totals) {
+  memcpy(totals, &retired, sizeof(*totals));
+  for (const ThreadStats *t = threads; t != NULL; t = t->next) {
+    Accumulate((uint64_t *)totals, &t->stats);
+  }
+}
+
+/* Folds the block of an exiting thread into the retired totals */
+static void ThreadExit(void *arg) {
+  ThreadStats *t = arg;
+  local = NULL; // a later call from another destructor registers again
+  pthread_mutex_lock(&lock);
+  Accumulate((uint64_t *)&retired, &t->stats);
+  if (t->prev != NULL) {
+    t->prev->next = t->next;
+  } else {
+    threads = t->next;
+  }
+  if (t->next != NULL) {
+    t->next->prev = t->prev;
+  }
+  pthread_mutex_unlock(&lock);
+  free(t);
+}
+
+static void CreateExitKey(void) { pthread_key_create(&exit_key, ThreadExit); }
+
+/* Returns NULL if the block cannot be allocated, the call then goes
+   uncounted. */
+static ThreadStats *Register(void) {
+  ThreadStats *t = calloc(1, sizeof(*t));
+  if (t == NULL) {
+    return NULL;
+  }
+  pthread_once(&key_once, CreateExitKey);
+  pthread_mutex_lock(&lock);
+  t->next = threads;
+  if (threads != NULL) {
+    threads->prev = t;
+  }
+  threads = t;
+  pthread_mutex_unlock(&lock);
+  pthread_setspecific(exit_key, t);
+  local = t;
+  return t;
+}
+
+static inline void Add(uint64_t *counter, uint64_t value) {
+  __atomic_store_n(counter, *counter + value, __ATOMIC_RELAXED);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Recording hooks                                                            */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+uint64_t HighwayHashStatsNow(void) {
+#if kLevel >= 2
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+void HighwayHashStatsRecord(HighwayHashStatsFunction function, size_t size,
+                            uint64_t start) {
+  ThreadStats *t = local != NULL ? local : Register();
+  if (t == NULL) {
+    return;
+  }
+  HighwayHashStatsCounters *counters = &t->stats.functions[function];
+  Add(&counters->calls, 1);
+  Add(&counters->bytes, size);
+#if kLevel >= 2
+  Add(&counters->cycles, __rdtsc() - start);
+#else
+  (void)start;
+#endif
+  Add(&counters->sizes[size != 0 ? 64 - __builtin_clzll(size) : 0], 1);
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Snapshot API                                                               */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* Resetting records the current totals instead of clearing the blocks,
+   which other threads may be writing to at the same time. */
+
+void HighwayHashStatsSnapshot(HighwayHashStats *stats) {
+  pthread_mutex_lock(&lock);
+  Totals(stats);
+  uint64_t *counters = (uint64_t *)stats;
+  const uint64_t *base = (const uint64_t *)&baseline;
+  for (size_t i = 0; i < kNumCounters; i++) {
+    counters[i] -= base[i];
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void HighwayHashStatsReset(void) {
+  pthread_mutex_lock(&lock);
+  Totals(&baseline);
+  pthread_mutex_unlock(&lock);
+}
+
+#else
+
+void HighwayHashStatsSnapshot(HighwayHashStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+}
+
+void HighwayHashStatsReset(void) {}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef C_HIGHWAYHASH_STATS_INTERNAL_H_
+#define C_HIGHWAYHASH_STATS_INTERNAL_H_
+
+#include "hh_c/highwayhash_stats.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Recording hooks, private to the library                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+/* HIGHWAYHASH_STATS is set by meson: 0 or undefined records nothing, 1
+   counts calls, bytes and sizes, 2 also TSC cycles. Without it both macros
+   expand to nothing, so the instrumented functions compile exactly as
+   before. */
+
+#if defined(HIGHWAYHASH_STATS) && HIGHWAYHASH_STATS
+
+uint64_t HighwayHashStatsNow(void);
+void HighwayHashStatsRecord(HighwayHashStatsFunction function, size_t size,
+                            uint64_t start);
+
+#define HIGHWAYHASH_STATS_BEGIN()                                              \
+  const uint64_t stats_start = HighwayHashStatsNow()
+#define HIGHWAYHASH_STATS_END(function, size)                                  \
+  HighwayHashStatsRecord(HIGHWAYHASH_STATS_##function, (size), stats_start)
+
+#else
+
+#define HIGHWAYHASH_STATS_BEGIN() ((void)0)
+#define HIGHWAYHASH_STATS_END(function, size) ((void)0)
+
+#endif
+
+#endif // C_HIGHWAYHASH_STATS_INTERNAL_H_
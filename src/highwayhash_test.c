@@ -1,8 +1,21 @@
 #include "hh_c/highwayhash.h"
+#include "hh_c/highwayhash_bloom.h"
+#include "hh_c/highwayhash_cdc.h"
+#include "hh_c/highwayhash_column.h"
+#include "hh_c/highwayhash_inline.h"
+#include "hh_c/highwayhash_map.h"
+#include "hh_c/highwayhash_shard.h"
+#include "hh_c/highwayhash_stats.h"
+#include "hh_c/highwayhash_tree.h"
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #define kMaxSize 64
 
@@ -41,13 +54,801 @@ void TestHash64(uint64_t expected, const uint8_t *data, size_t size,
   uint64_t hash = HighwayHash64(data, size, key);
   if (expected != hash) {
     printf("Test failed: expected %016" PRIx64 ", got %016" PRIx64
-           ", size: %d\n",
-           expected, hash, (int)size);
+           ", size: %d, backend: %s\n",
+           expected, hash, (int)size,
+           HighwayHashBackendName(HighwayHashGetBackend()));
     exit(1);
   }
 }
 
-int main() {
+/* The batch API must agree with one call per message, for any mix of sizes
+   and a count that is not a multiple of the internal lane count. */
+void TestBatch(void) {
+  enum { kNum = 67 };
+  uint8_t data[3 * kNum];
+  const uint8_t *ptrs[kNum];
+  size_t sizes[kNum];
+  uint64_t hashes64[kNum];
+  uint64_t hashes128[2 * kNum];
+  int i;
+  for (i = 0; i < 3 * kNum; i++) {
+    data[i] = (uint8_t)(i * 7 + 3);
+  }
+  for (i = 0; i < kNum; i++) {
+    ptrs[i] = data + i;
+    sizes[i] = (size_t)((i * 37) % (2 * kNum));
+  }
+  HighwayHash64Batch(ptrs, sizes, kNum, kTestKey1, hashes64);
+  HighwayHash128Batch(ptrs, sizes, kNum, kTestKey1, hashes128);
+  for (i = 0; i < kNum; i++) {
+    uint64_t expected128[2];
+    TestHash64(hashes64[i], ptrs[i], sizes[i], kTestKey1);
+    HighwayHash128(ptrs[i], sizes[i], kTestKey1, expected128);
+    if (expected128[0] != hashes128[2 * i] ||
+        expected128[1] != hashes128[2 * i + 1]) {
+      printf("Test failed: 128-bit batch mismatch, size: %d, backend: %s\n",
+             (int)sizes[i], HighwayHashBackendName(HighwayHashGetBackend()));
+      exit(1);
+    }
+  }
+}
+
+/* The multi-key API must agree with one call per key, for key counts that
+   are and are not multiples of the internal lane count. */
+void TestMultiKey(void) {
+  enum { kMaxKeys = 9 };
+  static const size_t kSizes[] = {0, 1, 3, 4, 15, 16, 31, 32, 33, 100};
+  uint8_t data[100];
+  uint64_t keys[4 * kMaxKeys];
+  uint64_t hashes[kMaxKeys];
+  size_t i;
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 11 + 5);
+  }
+  for (i = 0; i < 4 * kMaxKeys; i++) {
+    keys[i] = kTestKey1[i & 3] * (i / 4 + 1) + i;
+  }
+  for (i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); i++) {
+    for (size_t k = 1; k <= kMaxKeys; k++) {
+      HighwayHash64MultiKey(data, kSizes[i], keys, k, hashes);
+      for (size_t j = 0; j < k; j++) {
+        if (hashes[j] != HighwayHash64(data, kSizes[i], keys + 4 * j)) {
+          printf("Test failed: multi-key mismatch, size: %d, keys: %d, "
+                 "backend: %s\n",
+                 (int)kSizes[i], (int)k,
+                 HighwayHashBackendName(HighwayHashGetBackend()));
+          exit(1);
+        }
+      }
+    }
+  }
+}
+
+void TestHash128(const uint64_t *expected, const uint64_t *hash,
+                 size_t size) {
+  if (expected[0] != hash[0] || expected[1] != hash[1]) {
+    printf("Test failed: 128-bit fixed-width mismatch, size: %d, backend: "
+           "%s\n",
+           (int)size, HighwayHashBackendName(HighwayHashGetBackend()));
+    exit(1);
+  }
+}
+
+/* The fixed-width functions hash integers as their little-endian bytes. */
+void TestFixedWidth(void) {
+  uint8_t data[32];
+  uint64_t expected[2];
+  uint64_t hash[2];
+  int i;
+  for (i = 0; i < 32; i++) {
+    data[i] = (uint8_t)(0xA5 ^ (i * 29));
+  }
+  const uint32_t u32 = (uint32_t)data[0] | (uint32_t)data[1] << 8 |
+                       (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+  uint64_t u64 = 0;
+  for (i = 0; i < 8; i++) {
+    u64 |= (uint64_t)data[i] << (8 * i);
+  }
+
+  TestHash64(HighwayHash64_U32(u32, kTestKey1), data, 4, kTestKey1);
+  TestHash64(HighwayHash64_U64(u64, kTestKey1), data, 8, kTestKey1);
+  TestHash64(HighwayHash64_16B(data, kTestKey1), data, 16, kTestKey1);
+  TestHash64(HighwayHash64_32B(data, kTestKey1), data, 32, kTestKey1);
+
+  HighwayHash128(data, 4, kTestKey2, expected);
+  HighwayHash128_U32(u32, kTestKey2, hash);
+  TestHash128(expected, hash, 4);
+  HighwayHash128(data, 8, kTestKey2, expected);
+  HighwayHash128_U64(u64, kTestKey2, hash);
+  TestHash128(expected, hash, 8);
+  HighwayHash128(data, 16, kTestKey2, expected);
+  HighwayHash128_16B(data, kTestKey2, hash);
+  TestHash128(expected, hash, 16);
+  HighwayHash128(data, 32, kTestKey2, expected);
+  HighwayHash128_32B(data, kTestKey2, hash);
+  TestHash128(expected, hash, 32);
+}
+
+/* A pre-keyed hash equals the plain one, also across a backend switch. */
+void TestWithKey(const HighwayHashKey *hkey) {
+  uint8_t data[100];
+  uint64_t expected[4];
+  uint64_t hash[4];
+  int i;
+  for (i = 0; i < 100; i++) {
+    data[i] = (uint8_t)(i * 11 + 5);
+  }
+  for (size_t size = 0; size <= 100; size += 3) {
+    TestHash64(HighwayHash64WithKey(data, size, hkey), data, size, kTestKey1);
+
+    HighwayHash128(data, size, kTestKey1, expected);
+    HighwayHash128WithKey(data, size, hkey, hash);
+    TestHash128(expected, hash, size);
+
+    HighwayHash256(data, size, kTestKey1, expected);
+    HighwayHash256WithKey(data, size, hkey, hash);
+    if (memcmp(expected, hash, sizeof(hash)) != 0) {
+      printf("Test failed: 256-bit keyed mismatch, size: %d, backend: %s\n",
+             (int)size, HighwayHashBackendName(HighwayHashGetBackend()));
+      exit(1);
+    }
+
+    HighwayHashCat cat;
+    HighwayHashCatStartWithKey(&cat, hkey);
+    HighwayHashCatAppend(&cat, data, size / 2);
+    HighwayHashCatAppend(&cat, data + size / 2, size - size / 2);
+    TestHash64(HighwayHashCatFinish64(&cat), data, size, kTestKey1);
+  }
+}
+
+/* Fragments of every size up to a few packets, including empty ones, must
+   hash like the concatenated message. */
+void TestAppendV(void) {
+  enum { kNum = 40 };
+  uint8_t data[kNum * (kNum - 1) / 2];
+  struct iovec iov[kNum];
+  size_t size = 0;
+  int i;
+  for (i = 0; i < (int)sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 17 + 9);
+  }
+  for (i = 0; i < kNum; i++) {
+    // Sizes 0, 1, ..., kNum - 1 in a scrambled order.
+    const size_t num = (size_t)(i * 7) % kNum;
+    iov[i].iov_base = data + size;
+    iov[i].iov_len = num;
+    size += num;
+  }
+  for (int count = 0; count <= kNum; count += 3) {
+    size_t total = 0;
+    for (i = 0; i < count; i++) {
+      total += iov[i].iov_len;
+    }
+    HighwayHashCat cat;
+    HighwayHashCatStart(&cat, kTestKey1);
+    HighwayHashCatAppendV(&cat, iov, count);
+    TestHash64(HighwayHashCatFinish64(&cat), data, total, kTestKey1);
+  }
+}
+
+/* A serialized Cat state resumes to the same hash, and its bytes are the
+   same on every backend, so a state saved by one resumes on the others. */
+void TestSerialize(void) {
+  static uint8_t first_backend[HIGHWAYHASH_CAT_SERIALIZED_SIZE];
+  static int have_first_backend = 0;
+  uint8_t data[100];
+  uint8_t bytes[HIGHWAYHASH_CAT_SERIALIZED_SIZE];
+  HighwayHashCat cat;
+  size_t i;
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 13 + 1);
+  }
+  for (size_t split = 0; split <= sizeof(data); split += 11) {
+    HighwayHashCatStart(&cat, kTestKey1);
+    HighwayHashCatAppend(&cat, data, split);
+    HighwayHashCatSerialize(&cat, bytes);
+    memset(&cat, 0xA5, sizeof(cat));
+    if (HighwayHashCatDeserialize(&cat, bytes, sizeof(bytes)) != 0) {
+      printf("Test failed: deserialize, split: %d\n", (int)split);
+      exit(1);
+    }
+    HighwayHashCatAppend(&cat, data + split, sizeof(data) - split);
+    TestHash64(HighwayHashCatFinish64(&cat), data, sizeof(data), kTestKey1);
+  }
+
+  // A state with staged bytes, resumed from what the first backend wrote.
+  HighwayHashCatStart(&cat, kTestKey1);
+  HighwayHashCatAppend(&cat, data, 99);
+  HighwayHashCatSerialize(&cat, bytes);
+  if (!have_first_backend) {
+    memcpy(first_backend, bytes, sizeof(bytes));
+    have_first_backend = 1;
+  } else if (memcmp(first_backend, bytes, sizeof(bytes)) != 0 ||
+             HighwayHashCatDeserialize(&cat, first_backend,
+                                       sizeof(first_backend)) != 0) {
+    printf("Test failed: serialized state differs between backends, "
+           "backend: %s\n",
+           HighwayHashBackendName(HighwayHashGetBackend()));
+    exit(1);
+  }
+  HighwayHashCatAppend(&cat, data + 99, 1);
+  TestHash64(HighwayHashCatFinish64(&cat), data, sizeof(data), kTestKey1);
+
+  // Bad sizes, versions and corrupted bytes are rejected.
+  HighwayHashCatSerialize(&cat, bytes);
+  if (HighwayHashCatDeserialize(&cat, bytes, sizeof(bytes) - 1) == 0) {
+    printf("Test failed: deserialize accepted a short buffer\n");
+    exit(1);
+  }
+  for (i = 0; i < sizeof(bytes); i += 7) {
+    bytes[i] ^= 0x10;
+    if (HighwayHashCatDeserialize(&cat, bytes, sizeof(bytes)) == 0) {
+      printf("Test failed: deserialize accepted a flipped byte %d\n", (int)i);
+      exit(1);
+    }
+    bytes[i] ^= 0x10;
+  }
+
+  // So are nonzero reserved and padding bytes, even under a valid checksum.
+  static const size_t kReserved[] = {6, 7, 136 + 4, 167};
+  static const uint64_t kChecksumKey[4] = {1, 2, 3, 4};
+  for (i = 0; i < sizeof(kReserved) / sizeof(kReserved[0]); i++) {
+    uint8_t bad[HIGHWAYHASH_CAT_SERIALIZED_SIZE];
+    memcpy(bad, bytes, sizeof(bad));
+    bad[kReserved[i]] = 1;
+    const uint64_t checksum = HighwayHash64(bad, sizeof(bad) - 8, kChecksumKey);
+    for (int b = 0; b < 8; b++) {
+      bad[sizeof(bad) - 8 + b] = (uint8_t)(checksum >> (8 * b));
+    }
+    if (HighwayHashCatDeserialize(&cat, bad, sizeof(bad)) == 0) {
+      printf("Test failed: deserialize accepted reserved byte %d\n",
+             (int)kReserved[i]);
+      exit(1);
+    }
+  }
+}
+
+/* Prefix hashes equal hashing each prefix separately, also when the
+   checkpoints are spread over several appends. */
+void TestPrefixes(void) {
+  enum { kSize = 300, kNum = 9 };
+  static const size_t kOffsets[kNum] = {0, 0, 1, 31, 32, 33, 100, 256, 300};
+  uint8_t data[kSize];
+  uint64_t hashes64[kNum];
+  uint64_t hashes128[2 * kNum];
+  uint64_t expected[2];
+  int i;
+  for (i = 0; i < kSize; i++) {
+    data[i] = (uint8_t)(i * 5 + 2);
+  }
+  HighwayHash64Prefixes(data, kOffsets, kNum, kTestKey1, hashes64);
+  HighwayHash128Prefixes(data, kOffsets, kNum, kTestKey1, hashes128);
+  for (i = 0; i < kNum; i++) {
+    TestHash64(hashes64[i], data, kOffsets[i], kTestKey1);
+    HighwayHash128(data, kOffsets[i], kTestKey1, expected);
+    TestHash128(expected, hashes128 + 2 * i, kOffsets[i]);
+  }
+
+  // The same checkpoints, split over appends of 50 and 250 bytes.
+  HighwayHashCat cat;
+  size_t relative[kNum];
+  for (i = 0; i < kNum; i++) {
+    relative[i] = kOffsets[i] < 50 ? kOffsets[i] : kOffsets[i] - 50;
+  }
+  HighwayHashCatStart(&cat, kTestKey1);
+  HighwayHashCatAppendPrefixes64(&cat, data, 50, relative, 6, hashes64);
+  HighwayHashCatAppendPrefixes64(&cat, data + 50, kSize - 50, relative + 6,
+                                 kNum - 6, hashes64 + 6);
+  for (i = 0; i < kNum; i++) {
+    TestHash64(hashes64[i], data, kOffsets[i], kTestKey1);
+  }
+  TestHash64(HighwayHashCatFinish64(&cat), data, kSize, kTestKey1);
+}
+
+typedef struct {
+  HighwayHashChunk chunks[200];
+  size_t num;
+} ChunkList;
+
+void CollectChunk(const HighwayHashChunk *chunk, void *opaque) {
+  ChunkList *list = opaque;
+  if (list->num < 200) {
+    list->chunks[list->num] = *chunk;
+  }
+  list->num++;
+}
+
+/* Chunks tile the input within the size limits, carry the HighwayHash128 of
+   their bytes and do not depend on how the input was split into updates. */
+void TestCdc(void) {
+  enum { kSize = 300000 };
+  static const HighwayHashCdcOptions kOptions = {1024, 4096, 16384};
+  static uint8_t data[kSize];
+  static ChunkList whole;
+  static ChunkList pieces;
+  HighwayHashCdc cdc;
+  uint64_t state = 1;
+  size_t i;
+  for (i = 0; i < kSize; i++) {
+    state = state * 6364136223846793005 + 1442695040888963407;
+    data[i] = (uint8_t)(state >> 56);
+  }
+
+  whole.num = 0;
+  HighwayHashCdcInit(&cdc, kTestKey1, &kOptions);
+  HighwayHashCdcUpdate(&cdc, data, kSize, CollectChunk, &whole);
+  HighwayHashCdcFinish(&cdc, CollectChunk, &whole);
+
+  pieces.num = 0;
+  HighwayHashCdcInit(&cdc, kTestKey1, &kOptions);
+  for (i = 0; i < kSize; i += 777) {
+    const size_t num = kSize - i < 777 ? kSize - i : 777;
+    HighwayHashCdcUpdate(&cdc, data + i, num, CollectChunk, &pieces);
+  }
+  HighwayHashCdcFinish(&cdc, CollectChunk, &pieces);
+
+  uint64_t offset = 0;
+  int ok = whole.num > 1 && whole.num <= 200 && whole.num == pieces.num;
+  for (i = 0; ok && i < whole.num; i++) {
+    const HighwayHashChunk *chunk = &whole.chunks[i];
+    uint64_t expected[2];
+    HighwayHash128(data + chunk->offset, chunk->length, kTestKey1, expected);
+    ok = chunk->offset == offset && chunk->length <= kOptions.max_size &&
+         (chunk->length >= kOptions.min_size || i + 1 == whole.num) &&
+         memcmp(chunk->hash, expected, sizeof(expected)) == 0 &&
+         memcmp(chunk, &pieces.chunks[i], sizeof(*chunk)) == 0;
+    offset += chunk->length;
+  }
+  if (!ok || offset != kSize) {
+    printf("Test failed: chunk %d of %d, backend: %s\n", (int)i,
+           (int)whole.num, HighwayHashBackendName(HighwayHashGetBackend()));
+    exit(1);
+  }
+}
+
+/* Tree hashes follow the documented construction and do not depend on the
+   number of threads. */
+void TestTree(void) {
+  enum { kSize = 10000, kLeaf = 1024 };
+  static uint8_t data[kSize];
+  uint64_t leaf_key[4];
+  uint64_t root_key[4];
+  int i;
+  for (i = 0; i < kSize; i++) {
+    data[i] = (uint8_t)(i * 13 + 1);
+  }
+  for (i = 0; i < 4; i++) {
+    leaf_key[i] = kTestKey1[i] ^ kHighwayHashTreeLeafDomain[i];
+    root_key[i] = kTestKey1[i] ^ kHighwayHashTreeRootDomain[i];
+  }
+
+  HighwayHashCat cat;
+  HighwayHashCatStart(&cat, root_key);
+  for (i = 0; i < kSize; i += kLeaf) {
+    uint64_t digest[4];
+    uint8_t bytes[32];
+    const size_t size = kSize - i < kLeaf ? kSize - i : kLeaf;
+    HighwayHash256(data + i, size, leaf_key, digest);
+    for (int j = 0; j < 32; j++) {
+      bytes[j] = (uint8_t)(digest[j / 8] >> (8 * (j % 8)));
+    }
+    HighwayHashCatAppend(&cat, bytes, sizeof(bytes));
+  }
+  uint8_t trailer[16];
+  for (i = 0; i < 8; i++) {
+    trailer[i] = (uint8_t)((uint64_t)kSize >> (8 * i));
+    trailer[8 + i] = (uint8_t)((uint64_t)kLeaf >> (8 * i));
+  }
+  HighwayHashCatAppend(&cat, trailer, sizeof(trailer));
+  const uint64_t expected = HighwayHashCatFinish64(&cat);
+
+  for (unsigned threads = 1; threads <= 16; threads *= 2) {
+    HighwayHashTreeOptions options = {kLeaf, threads};
+    const uint64_t hash = HighwayHashTree64(data, kSize, kTestKey1, &options);
+    if (hash != expected) {
+      printf("Test failed: tree hash %016" PRIx64 " with %u threads, "
+             "expected %016" PRIx64 ", backend: %s\n",
+             hash, threads, expected,
+             HighwayHashBackendName(HighwayHashGetBackend()));
+      exit(1);
+    }
+  }
+}
+
+void ColumnFail(const char *what, int row) {
+  printf("Test failed: column %s, row %d, backend: %s\n", what, row,
+         HighwayHashBackendName(HighwayHashGetBackend()));
+  exit(1);
+}
+
+/* Valid rows hash like HighwayHash64WithKey, null rows to the null hash,
+   across chunk boundaries and with rows of every length up to a packet. */
+void TestColumn(const HighwayHashKey *hkey) {
+  enum { kRows = 150, kWidth = 12, kStride = 16 };
+  static uint8_t data[kRows * 40];
+  int32_t offsets[kRows + 1];
+  int64_t large_offsets[kRows + 1];
+  uint8_t validity[(kRows + 7) / 8];
+  uint64_t hashes[kRows];
+  uint64_t large_hashes[kRows];
+  uint64_t fixed_hashes[kRows];
+  int i;
+  for (i = 0; i < (int)sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 29 + 3);
+  }
+  offsets[0] = 5; // an Arrow slice need not start at 0
+  for (i = 0; i < kRows; i++) {
+    offsets[i + 1] = offsets[i] + (i * 7) % 37;
+  }
+  for (i = 0; i <= kRows; i++) {
+    large_offsets[i] = offsets[i];
+  }
+  memset(validity, 0, sizeof(validity));
+  for (i = 0; i < kRows; i++) {
+    if (i % 5 != 3) {
+      validity[i / 8] |= (uint8_t)(1 << (i % 8));
+    }
+  }
+
+  HighwayHashColumnBinary(offsets, data, validity, kRows, hkey, hashes);
+  HighwayHashColumnLargeBinary(large_offsets, data, validity, kRows, hkey,
+                               large_hashes);
+  HighwayHashColumnFixed(data, kWidth, kStride, validity, kRows, hkey,
+                         fixed_hashes);
+  for (i = 0; i < kRows; i++) {
+    const int valid = i % 5 != 3;
+    const uint64_t expected =
+        valid ? HighwayHash64WithKey(data + offsets[i],
+                                     (size_t)(offsets[i + 1] - offsets[i]),
+                                     hkey)
+              : HIGHWAYHASH_COLUMN_NULL_HASH;
+    const uint64_t expected_fixed =
+        valid ? HighwayHash64WithKey(data + i * kStride, kWidth, hkey)
+              : HIGHWAYHASH_COLUMN_NULL_HASH;
+    if (hashes[i] != expected || large_hashes[i] != expected) {
+      ColumnFail("binary", i);
+    }
+    if (fixed_hashes[i] != expected_fixed) {
+      ColumnFail("fixed", i);
+    }
+  }
+
+  // Without a bitmap every row is valid.
+  HighwayHashColumnBinary(offsets, data, NULL, kRows, hkey, hashes);
+  if (hashes[3] != HighwayHash64WithKey(data + offsets[3],
+                                        (size_t)(offsets[4] - offsets[3]),
+                                        hkey)) {
+    ColumnFail("without validity", 3);
+  }
+
+  // Combining two columns depends on their order.
+  uint64_t ab[kRows];
+  uint64_t ba[kRows];
+  memcpy(ab, hashes, sizeof(ab));
+  HighwayHashColumnCombine(ab, fixed_hashes, kRows);
+  memcpy(ba, fixed_hashes, sizeof(ba));
+  HighwayHashColumnCombine(ba, hashes, kRows);
+  for (i = 0; i < kRows; i++) {
+    if (ab[i] == ba[i] || ab[i] == hashes[i]) {
+      ColumnFail("combine", i);
+    }
+  }
+}
+
+void ShardFail(const char *what, int i) {
+  printf("Test failed: shard %s, request %d, backend: %s\n", what, i,
+         HighwayHashBackendName(HighwayHashGetBackend()));
+  exit(1);
+}
+
+/* Rendezvous scores follow the documented node keys, lookups pick the best
+   score and removing a node only moves the requests it won. Jump hashing
+   only ever moves requests into a new last bucket. */
+void TestShard(const HighwayHashKey *hkey) {
+  enum { kNodes = 37, kRequests = 200 };
+  uint64_t ids[kNodes];
+  uint64_t scores[kNodes];
+  uint8_t request[20];
+  HighwayHashRendezvous all;
+  HighwayHashRendezvous fewer;
+  int i;
+  for (i = 0; i < kNodes; i++) {
+    ids[i] = (uint64_t)i * 1000003 + 17;
+  }
+  if (HighwayHashRendezvousInit(&all, kTestKey1, ids, kNodes) != 0 ||
+      HighwayHashRendezvousInit(&fewer, kTestKey1, ids + 1, kNodes - 1) != 0) {
+    ShardFail("init", 0);
+  }
+  for (i = 0; i < kRequests; i++) {
+    const size_t size = (size_t)i % sizeof(request);
+    for (size_t j = 0; j < size; j++) {
+      request[j] = (uint8_t)(i * 31 + j);
+    }
+    HighwayHashRendezvousScores(&all, request, size, scores);
+    size_t best = 0;
+    for (int n = 0; n < kNodes; n++) {
+      uint8_t id_bytes[8];
+      uint64_t node_key[4];
+      for (int b = 0; b < 8; b++) {
+        id_bytes[b] = (uint8_t)(ids[n] >> (8 * b));
+      }
+      HighwayHash256(id_bytes, sizeof(id_bytes), kTestKey1, node_key);
+      if (scores[n] != HighwayHash64(request, size, node_key)) {
+        ShardFail("score", i);
+      }
+      if (scores[n] > scores[best]) {
+        best = (size_t)n;
+      }
+    }
+    const size_t node = HighwayHashRendezvousLookup(&all, request, size);
+    if (node != best) {
+      ShardFail("lookup", i);
+    }
+    // Node 0 is missing from the smaller set, whose indexes are shifted.
+    const size_t moved = HighwayHashRendezvousLookup(&fewer, request, size);
+    if (node != 0 && moved + 1 != node) {
+      ShardFail("removal", i);
+    }
+
+    const uint64_t hash = HighwayHash64WithKey(request, size, hkey);
+    uint32_t bucket = HighwayHashJump(hash, 1);
+    if (bucket != 0 || HighwayHashJumpShard(request, size, hkey, 1) != 0) {
+      ShardFail("jump with one bucket", i);
+    }
+    for (uint32_t buckets = 2; buckets <= 64; buckets++) {
+      const uint32_t next = HighwayHashJump(hash, buckets);
+      if (next != bucket && next != buckets - 1) {
+        ShardFail("jump", i);
+      }
+      bucket = next;
+    }
+  }
+  HighwayHashRendezvousFree(&all);
+  HighwayHashRendezvousFree(&fewer);
+}
+
+void BloomFail(const char *what, int i) {
+  printf("Test failed: bloom %s, key %d, backend: %s\n", what, i,
+         HighwayHashBackendName(HighwayHashGetBackend()));
+  exit(1);
+}
+
+/* No inserted key is ever missed, single and bulk calls agree, and the false
+   positive rate is near the documented one. */
+void TestBloom(void) {
+  enum { kKeys = 4000, kAbsent = 40000, kBitsPerKey = 10 };
+  static uint8_t keys[kKeys + kAbsent][8];
+  static const uint8_t *ptrs[kKeys + kAbsent];
+  static size_t sizes[kKeys + kAbsent];
+  static uint8_t results[kKeys + kAbsent];
+  HighwayHashBloom bloom;
+  int i;
+  for (i = 0; i < kKeys + kAbsent; i++) {
+    for (int b = 0; b < 8; b++) {
+      keys[i][b] = (uint8_t)((uint64_t)i * 0x9E3779B97F4A7C15 >> (8 * b));
+    }
+    ptrs[i] = keys[i];
+    // The low 4 bytes of an odd multiple are distinct, so are the keys.
+    sizes[i] = 4 + (size_t)i % 5;
+  }
+  if (HighwayHashBloomInit(&bloom, kTestKey1, kKeys, kBitsPerKey) != 0) {
+    BloomFail("init", 0);
+  }
+  // Half the keys one at a time, half in bulk, with a chunk left over.
+  for (i = 0; i < kKeys / 2; i++) {
+    HighwayHashBloomInsert(&bloom, ptrs[i], sizes[i]);
+  }
+  HighwayHashBloomInsertBatch(&bloom, ptrs + kKeys / 2, sizes + kKeys / 2,
+                              kKeys / 2);
+
+  HighwayHashBloomQueryBatch(&bloom, ptrs, sizes, kKeys + kAbsent, results);
+  int false_positives = 0;
+  for (i = 0; i < kKeys + kAbsent; i++) {
+    const int found = HighwayHashBloomQuery(&bloom, ptrs[i], sizes[i]);
+    if (found != results[i]) {
+      BloomFail("bulk query", i);
+    }
+    if (i < kKeys && !found) {
+      BloomFail("false negative", i);
+    }
+    false_positives += i >= kKeys && found;
+  }
+  if (false_positives > kAbsent / 50) {
+    BloomFail("false positive rate", false_positives);
+  }
+  HighwayHashBloomFree(&bloom);
+}
+
+void MapFail(const char *what, int i) {
+  printf("Test failed: map %s, key %d, backend: %s\n", what, i,
+         HighwayHashBackendName(HighwayHashGetBackend()));
+  exit(1);
+}
+
+/* Erasing must leave every other key reachable, however long the probe
+   sequences through the erased slots were. */
+void TestMap(void) {
+  enum { kNum = 3000 };
+  static uint8_t keys[kNum][4];
+  HighwayHashMap map;
+  size_t iter = 0;
+  int i;
+  if (HighwayHashMapInit(&map, kTestKey2) != 0) {
+    MapFail("init", 0);
+  }
+  for (i = 0; i < kNum; i++) {
+    for (int j = 0; j < 4; j++) {
+      keys[i][j] = (uint8_t)(i >> (8 * j));
+    }
+    if (HighwayHashMapInsert(&map, keys[i], 4, keys[i]) != 1) {
+      MapFail("insert", i);
+    }
+  }
+  // A prefix is a different key.
+  if (HighwayHashMapFind(&map, keys[0], 3) != NULL ||
+      HighwayHashMapInsert(&map, keys[0], 4, NULL) != 0 ||
+      *HighwayHashMapFind(&map, keys[0], 4) != NULL) {
+    MapFail("replace", 0);
+  }
+  HighwayHashMapInsert(&map, keys[0], 4, keys[0]);
+
+  for (i = 1; i < kNum; i += 2) {
+    if (HighwayHashMapErase(&map, keys[i], 4) != 1 ||
+        HighwayHashMapErase(&map, keys[i], 4) != 0) {
+      MapFail("erase", i);
+    }
+  }
+  if (map.size != kNum / 2) {
+    MapFail("size", (int)map.size);
+  }
+  for (i = 0; i < kNum; i++) {
+    void **value = HighwayHashMapFind(&map, keys[i], 4);
+    if (i % 2 == 0 ? value == NULL || *value != keys[i] : value != NULL) {
+      MapFail("find", i);
+    }
+  }
+  for (i = 0; HighwayHashMapNext(&map, &iter) != NULL; i++) {
+  }
+  if (i != kNum / 2) {
+    MapFail("iteration", i);
+  }
+
+  for (i = 1; i < kNum; i += 2) {
+    HighwayHashMapInsert(&map, keys[i], 4, keys[i]);
+  }
+  for (i = 0; i < kNum; i++) {
+    void **value = HighwayHashMapFind(&map, keys[i], 4);
+    if (value == NULL || *value != keys[i]) {
+      MapFail("reinsert", i);
+    }
+  }
+  HighwayHashMapFree(&map);
+}
+
+/* Inputs that end right before an unmapped page must hash without reading
+   past their end, and match the same bytes elsewhere. */
+void TestPageEnd(void) {
+  const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  uint8_t *map = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED || mprotect(map + page, page, PROT_NONE) != 0) {
+    printf("Test failed: cannot map a guard page\n");
+    exit(1);
+  }
+  uint8_t *end = map + page;
+  for (size_t i = 1; i <= kMaxSize; i++) {
+    end[-(ptrdiff_t)i] = (uint8_t)(kMaxSize - i);
+  }
+  for (size_t size = 0; size <= kMaxSize; size++) {
+    uint8_t copy[kMaxSize];
+    memcpy(copy, end - size, size);
+    TestHash64(HighwayHash64(copy, size, kTestKey1), end - size, size,
+               kTestKey1);
+  }
+  munmap(map, 2 * page);
+}
+
+/* The inline definitions must agree with the library, here reached
+   through the Cat API so the check means the same with -Dinline_api. */
+void TestInline(const HighwayHashKey *hkey) {
+  uint8_t data[kMaxSize + 32];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 7 + 1);
+  }
+  for (size_t size = 0; size <= sizeof(data); size++) {
+    uint64_t expected[4], hash[4];
+    HighwayHashCat cat;
+    HighwayHashCatStart(&cat, kTestKey1);
+    HighwayHashCatAppend(&cat, data, size);
+    const uint64_t expected64 = HighwayHashCatFinish64(&cat);
+    if (HighwayHashInline64(data, size, kTestKey1) != expected64 ||
+        HighwayHashInline64WithKey(data, size, hkey) != expected64) {
+      printf("Test failed: inline 64, size %d\n", (int)size);
+      exit(1);
+    }
+    HighwayHashCatFinish128(&cat, expected);
+    HighwayHashInline128(data, size, kTestKey1, hash);
+    HighwayHashInline128WithKey(data, size, hkey, hash + 2);
+    if (memcmp(hash, expected, 16) != 0 ||
+        memcmp(hash + 2, expected, 16) != 0) {
+      printf("Test failed: inline 128, size %d\n", (int)size);
+      exit(1);
+    }
+    HighwayHashCatFinish256(&cat, expected);
+    HighwayHashInline256(data, size, kTestKey1, hash);
+    if (memcmp(hash, expected, 32) != 0) {
+      printf("Test failed: inline 256, size %d\n", (int)size);
+      exit(1);
+    }
+    HighwayHashInline256WithKey(data, size, hkey, hash);
+    if (memcmp(hash, expected, 32) != 0) {
+      printf("Test failed: inline 256 with key, size %d\n", (int)size);
+      exit(1);
+    }
+  }
+}
+
+void StatsFail(const char *what, uint64_t got) {
+  printf("Test failed: stats %s, got %" PRIu64 ", backend: %s\n", what, got,
+         HighwayHashBackendName(HighwayHashGetBackend()));
+  exit(1);
+}
+
+static void *StatsThread(void *data) {
+  HighwayHashCat cat;
+  HighwayHashCatStart(&cat, kTestKey1);
+  HighwayHashCatAppend(&cat, data, 40);
+  HighwayHashCatFinish64(&cat);
+  return NULL;
+}
+
+/* Counts of a thread must survive its exit, and a reset must hide every
+   earlier call. Without -Dstats everything reads as zero. */
+void TestStats(void) {
+  uint8_t data[100] = {0};
+  uint64_t hash[2];
+  HighwayHashStats stats;
+  pthread_t thread;
+  HighwayHashStatsReset();
+  HighwayHash64(data, 100, kTestKey1);
+  HighwayHash128(data, 0, kTestKey1, hash);
+  if (pthread_create(&thread, NULL, StatsThread, data) != 0 ||
+      pthread_join(thread, NULL) != 0) {
+    StatsFail("thread", 0);
+  }
+  HighwayHashStatsSnapshot(&stats);
+
+  const int on = HighwayHashStatsLevel() != 0;
+  const HighwayHashStatsCounters *h64 =
+      &stats.functions[HIGHWAYHASH_STATS_HASH64];
+  const HighwayHashStatsCounters *h128 =
+      &stats.functions[HIGHWAYHASH_STATS_HASH128];
+  const HighwayHashStatsCounters *append =
+      &stats.functions[HIGHWAYHASH_STATS_CAT_APPEND];
+  const HighwayHashStatsCounters *finish =
+      &stats.functions[HIGHWAYHASH_STATS_CAT_FINISH64];
+  if (h64->calls != (uint64_t)on || h64->bytes != 100u * on ||
+      h64->sizes[7] != (uint64_t)on) {
+    StatsFail("hash64", h64->calls);
+  }
+  if (h128->calls != (uint64_t)on || h128->sizes[0] != (uint64_t)on) {
+    StatsFail("hash128", h128->calls);
+  }
+  if (append->bytes != 40u * on || finish->bytes != 8u * on) {
+    StatsFail("thread counts", append->bytes);
+  }
+  if ((HighwayHashStatsLevel() == 2) != (h64->cycles != 0)) {
+    StatsFail("cycles", h64->cycles);
+  }
+
+  HighwayHashStatsReset();
+  HighwayHashStatsSnapshot(&stats);
+  if (stats.functions[HIGHWAYHASH_STATS_HASH64].calls != 0) {
+    StatsFail("reset", stats.functions[HIGHWAYHASH_STATS_HASH64].calls);
+  }
+}
+
+void TestBackend(const HighwayHashKey *hkey) {
   uint8_t data[kMaxSize + 1] = {0};
   int i;
   for (i = 0; i <= kMaxSize; i++) {
@@ -63,6 +864,39 @@ int main() {
   /* 128-bit and 256-bit tests to be added when they are declared frozen in the
      C++ version */
 
+  TestFixedWidth();
+  TestWithKey(hkey);
+  TestAppendV();
+  TestSerialize();
+  TestPrefixes();
+  TestCdc();
+  TestMap();
+  TestBatch();
+  TestMultiKey();
+  TestColumn(hkey);
+  TestShard(hkey);
+  TestBloom();
+  TestTree();
+  TestStats();
+  TestPageEnd();
+  TestInline(hkey);
+}
+
+int main() {
+  const HighwayHashBackend best = HighwayHashGetBackend();
+  HighwayHashKey hkey;
+  HighwayHashKeyInit(&hkey, kTestKey1);
+  int backend;
+  for (backend = 0; backend < HIGHWAYHASH_BACKEND_COUNT; backend++) {
+    if (HighwayHashSetBackend((HighwayHashBackend)backend) != 0) {
+      printf("Skipping backend %s\n",
+             HighwayHashBackendName((HighwayHashBackend)backend));
+      continue;
+    }
+    TestBackend(&hkey);
+  }
+  HighwayHashSetBackend(best);
+
   printf("Test success\n");
   return 0;
 }
@@ -0,0 +1,162 @@
+#define _POSIX_C_SOURCE 200809L
+#include "hh_c/highwayhash_tree.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Part of the tree output format, changing them changes every tree hash */
+const uint64_t kHighwayHashTreeLeafDomain[4] = {
+    0x656572742f635f68, 0x00006661656c2f, 0x9e3779b97f4a7c15,
+    0xbf58476d1ce4e5b9};
+const uint64_t kHighwayHashTreeRootDomain[4] = {
+    0x656572742f635f68, 0x0000746f6f722f, 0x94d049bb133111eb,
+    0x2545f4914f6cdd1d};
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Internal implementation                                                    */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+  size_t leaf_size;
+  size_t num_leaves;
+  uint64_t leaf_key[4];
+  uint8_t *digests; /* num_leaves * 32 bytes */
+  atomic_size_t next;
+} TreeJob;
+
+static void Store64LE(uint64_t value, uint8_t *dst) {
+  for (int i = 0; i < 8; i++) {
+    dst[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static void HashLeaf(const TreeJob *job, size_t index, uint8_t *digest) {
+  const size_t offset = index * job->leaf_size;
+  const size_t remaining = job->size - offset;
+  const size_t size = remaining < job->leaf_size ? remaining : job->leaf_size;
+  uint64_t hash[4];
+  HighwayHash256(job->data + offset, size, job->leaf_key, hash);
+  for (int i = 0; i < 4; i++) {
+    Store64LE(hash[i], digest + 8 * i);
+  }
+}
+
+/* Leaves are handed out one at a time, each is large enough that the
+   shared counter is never contended. */
+static void *HashLeaves(void *arg) {
+  TreeJob *job = arg;
+  for (;;) {
+    const size_t index =
+        atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+    if (index >= job->num_leaves) {
+      return NULL;
+    }
+    HashLeaf(job, index, job->digests + 32 * index);
+  }
+}
+
+static unsigned NumThreads(const HighwayHashTreeOptions *options,
+                           size_t num_leaves) {
+  size_t threads = options != NULL ? options->num_threads : 0;
+  if (threads == 0) {
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (size_t)online : 1;
+  }
+  if (threads > num_leaves) {
+    threads = num_leaves;
+  }
+  return (unsigned)threads;
+}
+
+/* Leaves the root input in cat, ready for one of the Finish calls. */
+static void TreeRoot(const uint8_t *data, size_t size, const uint64_t *key,
+                     const HighwayHashTreeOptions *options,
+                     HighwayHashCat *cat) {
+  TreeJob job;
+  job.data = data;
+  job.size = size;
+  job.leaf_size = options != NULL && options->leaf_size != 0
+                      ? options->leaf_size
+                      : HIGHWAYHASH_TREE_DEFAULT_LEAF_SIZE;
+  job.num_leaves = size == 0 ? 1 : (size - 1) / job.leaf_size + 1;
+  job.digests = NULL;
+  atomic_init(&job.next, 0);
+
+  uint64_t root_key[4];
+  for (int i = 0; i < 4; i++) {
+    job.leaf_key[i] = key[i] ^ kHighwayHashTreeLeafDomain[i];
+    root_key[i] = key[i] ^ kHighwayHashTreeRootDomain[i];
+  }
+  HighwayHashCatStart(cat, root_key);
+
+  const unsigned threads = NumThreads(options, job.num_leaves);
+  if (threads > 1 && job.num_leaves <= SIZE_MAX / 32) {
+    job.digests = malloc(job.num_leaves * 32);
+  }
+
+  if (job.digests == NULL) {
+    // Single thread, or no memory for the digests: stream them instead.
+    for (size_t i = 0; i < job.num_leaves; i++) {
+      uint8_t digest[32];
+      HashLeaf(&job, i, digest);
+      HighwayHashCatAppend(cat, digest, sizeof(digest));
+    }
+  } else {
+    pthread_t *workers = malloc(sizeof(pthread_t) * (threads - 1));
+    unsigned started = 0;
+    if (workers != NULL) {
+      while (started < threads - 1 &&
+             pthread_create(&workers[started], NULL, HashLeaves, &job) == 0) {
+        started++;
+      }
+    }
+    // The caller is a worker too, and finishes the job alone if no thread
+    // could be started.
+    HashLeaves(&job);
+    for (unsigned i = 0; i < started; i++) {
+      pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    HighwayHashCatAppend(cat, job.digests, job.num_leaves * 32);
+    free(job.digests);
+  }
+
+  uint8_t trailer[16];
+  Store64LE((uint64_t)size, trailer);
+  Store64LE((uint64_t)job.leaf_size, trailer + 8);
+  HighwayHashCatAppend(cat, trailer, sizeof(trailer));
+}
+
+/*////////////////////////////////////////////////////////////////////////////*/
+/* Tree mode API                                                              */
+/*////////////////////////////////////////////////////////////////////////////*/
+
+uint64_t HighwayHashTree64(const uint8_t *data, size_t size,
+                           const uint64_t *key,
+                           const HighwayHashTreeOptions *options) {
+  HighwayHashCat cat;
+  TreeRoot(data, size, key, options, &cat);
+  return HighwayHashCatFinish64(&cat);
+}
+
+void HighwayHashTree128(const uint8_t *data, size_t size, const uint64_t *key,
+                        const HighwayHashTreeOptions *options,
+                        uint64_t *hash) {
+  HighwayHashCat cat;
+  TreeRoot(data, size, key, options, &cat);
+  HighwayHashCatFinish128(&cat, hash);
+}
+
+void HighwayHashTree256(const uint8_t *data, size_t size, const uint64_t *key,
+                        const HighwayHashTreeOptions *options,
+                        uint64_t *hash) {
+  HighwayHashCat cat;
+  TreeRoot(data, size, key, options, &cat);
+  HighwayHashCatFinish256(&cat, hash);
+}